@@ -1,131 +1,116 @@
-#include <algorithm>
+#include <future>
 
 #include "game.h"
 #include "ai.h"
+#include "book.h"
 #include "constants.h"
+#include "movegen.h"
+#include "search.h"
 
-// This AI is "greedy", meaning that it only looks at the effect that its next
-// move will have on the state of the game. It does this by looking at how each
-// possible move will affect how its pieces are being attacked by the other side,
-// then it adds the possible effects of pieces it can take, plus how many of the
-// opponent's pieces it can endanger with the next move, then chooses the move
-// that minimises its losses and maximizes its gains. It is easy to defeat with
-// a bit of planning since it has no concent of checkmate, how to achieve it, or
-// how to defend it. It is, however, adequate for this project since an AI is
-// optional and isn't really the focus of the project.
+// The AI searches the game tree with iterative deepening alpha-beta (see
+// search.h) and plays the first move of the best line it found. The search
+// and its transposition table are kept between moves so later searches can
+// reuse what earlier ones learned.
 
-class PossibleMove {
-public:
-	Point from, to;
-	Piece piece;
-	int material;
-	bool defensive;
-	PossibleMove() : from(Point(0, 0)), to(Point(0, 0)) {}
-	PossibleMove(Point from, Point to, int material, bool defensive) : from(from), to(to), material(material), defensive(defensive) {}
-};
+// How long the AI thinks about each move, in milliseconds
+static constexpr int AI_MOVE_TIME = 1000;
+// The AI plays from a Polyglot book when book.bin is in the working directory
+static constexpr const char* BOOK_PATH = "book.bin";
+
+static bool ponderingEnabled = true;
+static std::future<SearchResult> ponderSearch;
+// The position being pondered, the one the player is expected to reach
+static uint64_t ponderKey = 0;
 
 int getMaterialValue(PieceType type) {
-	if (type == PieceType::PAWN) {
-		return 1;
-	}
-	else if (type == PieceType::BISHOP || type == PieceType::KNIGHT) {
-		return 3;
+	// The king's value is non-standard, but gives the AI a bit of incentive to put the player in check
+	static constexpr int values[] = { 1, 3, 3, 5, 9, 3, 0 };
+	return values[static_cast<int>(type)];
+}
+
+Search& getSearch() {
+	static Search search;
+	return search;
+}
+
+OpeningBook& getBook() {
+	static OpeningBook book;
+	static bool opened = false;
+	if (!opened) {
+		opened = true;
+		book.open(BOOK_PATH);
 	}
-	else if (type == PieceType::ROOK) {
-		return 5;
+	return book;
+}
+
+bool isPonderingEnabled() {
+	return ponderingEnabled;
+}
+
+void setPonderingEnabled(bool enabled) {
+	ponderingEnabled = enabled;
+	if (!enabled) {
+		stopPondering();
 	}
-	else if (type == PieceType::QUEEN) {
-		return 9;
+}
+
+// Ends the pondering search, keeping its result only if the player made the
+// expected move
+SearchResult finishPondering(const Game& game) {
+	if (!ponderSearch.valid()) {
+		return SearchResult();
 	}
-	else if (type == PieceType::KING) {
-		return 3; // Non-standard, but gives the AI a bit of incentive to put the player in check
+	if (game.getKey() != ponderKey) {
+		stopPondering();
+		return SearchResult();
 	}
-	else {
-		return 0;
+	getSearch().ponderHit();
+	return ponderSearch.get();
+}
+
+void stopPondering() {
+	if (!ponderSearch.valid()) {
+		return;
 	}
+	getSearch().stop();
+	ponderSearch.get();
 }
 
-int getEndangeredMaterial(Game& game, PieceColor color) {
-	int endangeredMaterial = 0;
-	for (int y = 0; y < BOARD_WIDTH; y++) {
-		for (int x = 0; x < BOARD_HEIGHT; x++) {
-			Point point(x, y);
-			if (game.hasPiece(point)) {
-				Piece piece = game.getPiece(point);
-				if (piece.getColor() != color) {
-					for (Point to : piece.getValidMoves(game, point)) {
-						if (game.hasPiece(to)) {
-							Piece taken = game.getPiece(to);
-							if (taken.getColor() == color) {
-								endangeredMaterial += getMaterialValue(taken.getType());
-							}
-						}
-					}
-				}
-			}
-		}
+void startPondering(const Game& game, Move expected) {
+	MoveList moves;
+	Game position = game;
+	generateLegalMoves(position, position.getCurrentTurn(), moves);
+	if (!moves.contains(expected)) {
+		return;
 	}
-	return endangeredMaterial;
+	position.makeMove(expected);
+	ponderKey = position.getKey();
+	SearchLimits limits;
+	limits.moveTime = AI_MOVE_TIME;
+	limits.ponder = true;
+	// Before the thread starts, so a stop or ponder hit can't come too early
+	getSearch().prepare(limits);
+	ponderSearch = std::async(std::launch::async, [position, limits]() mutable {
+		return getSearch().run(position, limits);
+	});
 }
 
 void aiMakeMove(Game& game) {
-	// Calculate how much material the other player can claim here first
-	// so we can use it to compare to possible moves later
-	int endangeredMaterial = getEndangeredMaterial(game, game.getCurrentTurn());
-	int attackingMaterial = getEndangeredMaterial(game, game.getCurrentTurn() == PieceColor::WHITE ? PieceColor::BLACK : PieceColor::WHITE);
-	std::vector<PossibleMove> moves;
-	for (int y = 0; y < BOARD_WIDTH; y++) {
-		for (int x = 0; x < BOARD_HEIGHT; x++) {
-			Point point(x, y);
-			if (game.hasPiece(point)) {
-				Piece piece = game.getPiece(point);
-				if (piece.getColor() == game.getCurrentTurn()) {
-					for (Point to : piece.getValidMoves(game, point)) {
-						// Look at the other color's possible moves here to see how the total material
-						// that the other player can claim will change after this move. If negative,
-						// assign defensive move value
-						// TODO: Investigate how slow this is
-						Game copy = game;
-						copy.setSelectedPiece(point);
-						copy.setSelectedTarget(to);
-						copy.moveToTarget();
-						int updatedEndangered = getEndangeredMaterial(copy, game.getCurrentTurn());
-						int updatedAttacking = getEndangeredMaterial(copy, game.getCurrentTurn() == PieceColor::WHITE ? PieceColor::BLACK : PieceColor::WHITE);
-						int materialChange = endangeredMaterial - updatedEndangered;
-						int attackingChange = (updatedAttacking - attackingMaterial) / 3; // What effect does this really have?
-						materialChange += attackingChange;
-						if (game.hasPiece(to)) {
-							Piece taken = game.getPiece(to);
-							if (taken.getColor() != game.getCurrentTurn()) {
-								materialChange += getMaterialValue(taken.getType());
-							}
-						}
-						PossibleMove move(point, to, materialChange, updatedEndangered < endangeredMaterial);
-						moves.push_back(move);
-					}
-				}
-			}
-		}
+	SearchResult result = finishPondering(game);
+	Move move = result.bestMove.isNone() ? getBook().probe(game, BookSelection::WEIGHTED) : result.bestMove;
+	if (move.isNone()) {
+		SearchLimits limits;
+		limits.moveTime = AI_MOVE_TIME;
+		result = getSearch().run(game, limits);
+		move = result.bestMove;
 	}
-	if (moves.size() == 0) {
+	if (move.isNone()) {
 		return;
 	}
-	std::random_shuffle(moves.begin(), moves.end());
-	PossibleMove move = moves.at(0);
-	for (PossibleMove m : moves) {
-		if (m.material > move.material) {
-			move = m;
-			continue;
-		}
-		if (m.material == move.material) {
-			// Pawn priority
-			if (m.defensive && !move.defensive) {
-				move = m;
-				continue;
-			}
-		}
-	}
-	game.setSelectedPiece(move.from);
-	game.setSelectedTarget(move.to);
+	game.setSelectedPiece(getPoint(move.getFrom()));
+	game.setSelectedTarget(getPoint(move.getTo()));
 	game.moveToTarget();
+	if (ponderingEnabled && result.pv.size() > 1 && result.pv[0] == move) {
+		startPondering(game, result.pv[1]);
+	}
 }
\ No newline at end of file
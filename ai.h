@@ -1,5 +1,17 @@
 #pragma once
 
+#include "piece.h"
+
 class Game;
+class Search;
+class OpeningBook;
 int getMaterialValue(PieceType type);
-void aiMakeMove(Game& game);
\ No newline at end of file
+Search& getSearch();
+OpeningBook& getBook();
+void aiMakeMove(Game& game);
+// After each move the AI searches the reply it expects while the player thinks
+bool isPonderingEnabled();
+void setPonderingEnabled(bool enabled);
+// Abandons the pondering search and waits for it, which has to happen before
+// the program exits since it runs on its own thread
+void stopPondering();
\ No newline at end of file
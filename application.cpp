@@ -1,22 +1,63 @@
+#include <algorithm>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "application.h"
+#include "ai.h"
+#include "search.h"
 #include "console.h"
 #include "game.h"
 #include "menu.h"
 #include "credits.h"
 
+void Application::displaySettings() {
+	while (true) {
+		std::vector<std::string> options{ "Threads", std::string("Pondering: ") + (isPonderingEnabled() ? "On" : "Off") };
+		std::string selection = displayMenu("Settings", options, "Pondering lets the AI think on your time.");
+		if (selection == options.at(0)) {
+			displayThreadSettings();
+		}
+		else if (selection == options.at(1)) {
+			setPonderingEnabled(!isPonderingEnabled());
+		}
+		else {
+			break;
+		}
+	}
+}
+
+void Application::displayThreadSettings() {
+	std::vector<std::string> options;
+	int hardwareThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	for (int threads = 1; threads < hardwareThreads; threads *= 2) {
+		options.push_back(std::to_string(threads));
+	}
+	options.push_back(std::to_string(hardwareThreads));
+	std::string selection = displayMenu("Select the number of threads the AI searches with", options,
+		"Currently using " + std::to_string(getSearch().getThreads()));
+	if (selection != "Escape") {
+		getSearch().setThreads(std::stoi(selection));
+	}
+}
+
 void Application::run() {
 	while (true) {
-		std::vector<std::string> options{ "Play", "Credits", "Exit" };
+		std::vector<std::string> options{ "Play", "Settings", "Credits", "Exit" };
 		std::string selection = displayMenu("Chess - Main Menu", options, "(C) 2019 - Dylan (Quantum64)");
 		if (selection == options.at(0)) {
 			std::vector<std::string> playOptions{ "Single Player", "Miltiplayer" };
 			std::string playSelection = displayMenu("Select Game Mode", playOptions);
+			if (getConsole().isClosed()) {
+				break;
+			}
 			Game game;
 			game.startGame(playSelection == playOptions.at(0));
 		}
 		else if (selection == options.at(1)) {
+			displaySettings();
+		}
+		else if (selection == options.at(2)) {
 			displayCredits();
 		}
 		else {
@@ -1,6 +1,9 @@
 #pragma once
 
 class Application {
+private:
+	void displaySettings();
+	void displayThreadSettings();
 public:
 	void run();
 };
\ No newline at end of file
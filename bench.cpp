@@ -0,0 +1,66 @@
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "game.h"
+#include "search.h"
+
+static const std::vector<const char*> BENCHMARK_POSITIONS = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+	"r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+};
+
+int runScalingBenchmark(int depth) {
+	static constexpr int threadCounts[] = { 1, 2, 4, 8, 16 };
+	std::cout << "Time to depth " << depth << " on " << BENCHMARK_POSITIONS.size() << " positions, "
+		<< std::thread::hardware_concurrency() << " hardware threads" << std::endl << std::endl;
+	std::cout << std::setw(8) << "Threads" << std::setw(12) << "Seconds" << std::setw(10) << "Speedup"
+		<< std::setw(14) << "Nodes" << std::setw(12) << "NPS" << std::setw(11) << "First cut" << std::setw(11) << "Branching" << std::setw(11) << "Pawn hits"
+		<< "   Nodes per thread" << std::endl;
+	double baseline = 0;
+	for (int threads : threadCounts) {
+		double seconds = 0;
+		uint64_t nodes = 0, cutoffs = 0, firstMoveCutoffs = 0, pawnProbes = 0, pawnHits = 0;
+		double branchingFactor = 0;
+		std::vector<uint64_t> threadNodes(threads);
+		for (const char* fen : BENCHMARK_POSITIONS) {
+			Game game;
+			game.fromFEN(fen);
+			// A fresh table per position so no run profits from an earlier one
+			Search search;
+			search.setThreads(threads);
+			SearchLimits limits;
+			limits.depth = depth;
+			SearchResult result = search.run(game, limits);
+			seconds += result.seconds;
+			nodes += result.nodes;
+			cutoffs += result.cutoffs;
+			firstMoveCutoffs += result.firstMoveCutoffs;
+			pawnProbes += result.pawnProbes;
+			pawnHits += result.pawnHits;
+			branchingFactor += result.branchingFactor / BENCHMARK_POSITIONS.size();
+			for (int i = 0; i < threads; i++) {
+				threadNodes[i] += result.threadNodes[i];
+			}
+		}
+		if (threads == 1) {
+			baseline = seconds;
+		}
+		std::cout << std::setw(8) << threads << std::setw(12) << std::fixed << std::setprecision(3) << seconds
+			<< std::setw(9) << std::setprecision(2) << (seconds > 0 ? baseline / seconds : 0) << "x"
+			<< std::setw(14) << nodes << std::setw(12) << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0)
+			<< std::setw(10) << std::setprecision(1) << (cutoffs > 0 ? 100.0 * firstMoveCutoffs / cutoffs : 0) << "%"
+			<< std::setw(11) << std::setprecision(2) << branchingFactor
+			<< std::setw(10) << std::setprecision(1) << (pawnProbes > 0 ? 100.0 * pawnHits / pawnProbes : 0) << "%  ";
+		for (uint64_t count : threadNodes) {
+			std::cout << " " << count;
+		}
+		std::cout << std::endl;
+	}
+	return 0;
+}
\ No newline at end of file
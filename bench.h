@@ -0,0 +1,6 @@
+#pragma once
+
+// Searches a fixed set of positions to the given depth with 1, 2, 4, 8 and 16
+// threads and prints the time to depth and speedup of each thread count, along
+// with how well the moves were ordered.
+int runScalingBenchmark(int depth);
\ No newline at end of file
@@ -0,0 +1,490 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "bitbase.h"
+#include "bitboard.h"
+#include "game.h"
+#include "mappedfile.h"
+
+static constexpr char BITBASE_MAGIC[8] = { 'B', 'I', 'T', 'B', 'A', 'S', 'E', '1' };
+static constexpr int MAX_PIECES = 2;
+// Pawnless tables only store the strong king in the a1-d1-d4 triangle
+static constexpr int CANONICAL_KING_COUNT = 10;
+
+// The strong side always plays up the board as white and the weak side has a
+// lone king, so a position is the two kings, the strong pieces and whose turn
+// it is. Each position takes a byte: zero when the strong side can't force
+// mate, otherwise one more than the plies to mate.
+struct BitbaseTable {
+	const char* name;
+	PieceType pieces[MAX_PIECES];
+	int pieceCount;
+	bool hasPawns() const { return pieces[0] == PieceType::PAWN; }
+	int getKingSquareCount() const { return hasPawns() ? SQUARE_COUNT : CANONICAL_KING_COUNT; }
+	size_t getSize() const {
+		size_t size = 2 * getKingSquareCount() * SQUARE_COUNT;
+		for (int i = 0; i < pieceCount; i++) {
+			size *= SQUARE_COUNT;
+		}
+		return size;
+	}
+};
+
+// KPK promotes into KQK and KRK, so those come first
+static const BitbaseTable TABLES[] = {
+	{ "KQK", { PieceType::QUEEN }, 1 },
+	{ "KRK", { PieceType::ROOK }, 1 },
+	{ "KPK", { PieceType::PAWN }, 1 },
+	{ "KBNK", { PieceType::BISHOP, PieceType::KNIGHT }, 2 }
+};
+static constexpr int TABLE_COUNT = sizeof(TABLES) / sizeof(TABLES[0]);
+static constexpr int KQK = 0, KRK = 1;
+
+struct BitbasePosition {
+	bool weakToMove;
+	int strongKing, weakKing;
+	int pieces[MAX_PIECES];
+};
+
+static const uint8_t* tables[TABLE_COUNT];
+static std::vector<uint8_t> generatedTables;
+static MappedFile bitbaseFile;
+// Set once every table is in place, probes miss until then
+static std::atomic<bool> bitbasesLoaded(false);
+static std::atomic<bool> generationCancelled(false);
+static std::thread generationThread;
+
+// Mirrors the board left to right, top to bottom and then along a1-h8
+inline int applySymmetry(int square, int symmetry) {
+	int x = square % BOARD_WIDTH, y = square / BOARD_WIDTH;
+	x = symmetry & 1 ? 7 - x : x;
+	y = symmetry & 2 ? 7 - y : y;
+	return symmetry & 4 ? getSquare(7 - y, 7 - x) : getSquare(x, y);
+}
+
+// The symmetry that brings the king into the a1-d1-d4 triangle
+inline int getSymmetry(int king) {
+	int x = king % BOARD_WIDTH, y = king / BOARD_WIDTH;
+	int symmetry = (x > 3 ? 1 : 0) | (y < 4 ? 2 : 0);
+	x = x > 3 ? 7 - x : x;
+	y = y < 4 ? 7 - y : y;
+	return 7 - y > x ? symmetry | 4 : symmetry;
+}
+
+inline bool isOnDiagonal(int square) {
+	return square % BOARD_WIDTH == 7 - square / BOARD_WIDTH;
+}
+
+struct KingIndices {
+	int indices[SQUARE_COUNT];
+	int squares[CANONICAL_KING_COUNT];
+	KingIndices() {
+		int count = 0;
+		for (int square = 0; square < SQUARE_COUNT; square++) {
+			indices[square] = getSymmetry(square) == 0 ? count : -1;
+			if (indices[square] >= 0) {
+				squares[count++] = square;
+			}
+		}
+	}
+};
+
+static const KingIndices KING_INDICES;
+
+size_t getIndex(const BitbaseTable& table, BitbasePosition position) {
+	if (!table.hasPawns()) {
+		int symmetry = getSymmetry(position.strongKing);
+		position.strongKing = applySymmetry(position.strongKing, symmetry);
+		position.weakKing = applySymmetry(position.weakKing, symmetry);
+		for (int i = 0; i < table.pieceCount; i++) {
+			position.pieces[i] = applySymmetry(position.pieces[i], symmetry);
+		}
+	}
+	size_t index = position.weakToMove ? 1 : 0;
+	index = index * table.getKingSquareCount() + (table.hasPawns() ? position.strongKing : KING_INDICES.indices[position.strongKing]);
+	index = index * SQUARE_COUNT + position.weakKing;
+	for (int i = 0; i < table.pieceCount; i++) {
+		index = index * SQUARE_COUNT + position.pieces[i];
+	}
+	return index;
+}
+
+BitbasePosition getPosition(const BitbaseTable& table, size_t index) {
+	BitbasePosition position;
+	for (int i = table.pieceCount - 1; i >= 0; i--) {
+		position.pieces[i] = static_cast<int>(index % SQUARE_COUNT);
+		index /= SQUARE_COUNT;
+	}
+	position.weakKing = static_cast<int>(index % SQUARE_COUNT);
+	index /= SQUARE_COUNT;
+	int king = static_cast<int>(index % table.getKingSquareCount());
+	position.strongKing = table.hasPawns() ? king : KING_INDICES.squares[king];
+	position.weakToMove = index / table.getKingSquareCount() != 0;
+	return position;
+}
+
+Bitboard getPieceAttacks(PieceType type, int square, Bitboard occupied) {
+	switch (type) {
+	case PieceType::PAWN:
+		return getPawnAttacks(static_cast<int>(PieceColor::WHITE), square);
+	case PieceType::KNIGHT:
+		return getKnightAttacks(square);
+	case PieceType::BISHOP:
+		return getBishopAttacks(square, occupied);
+	case PieceType::ROOK:
+		return getRookAttacks(square, occupied);
+	default:
+		return getQueenAttacks(square, occupied);
+	}
+}
+
+// Retrograde analysis: starting from every mate, positions are resolved one ply
+// further from mate at a time by taking moves back. A strong-to-move position is
+// won as soon as one move reaches a lost position, a weak-to-move position is
+// lost once every one of its moves reaches a won position.
+class BitbaseGenerator {
+private:
+	const BitbaseTable& table;
+	std::vector<uint8_t>& values;
+	const uint8_t* promotions[2];
+	Bitboard getOccupied(const BitbasePosition& position) const;
+	Bitboard getStrongAttacks(const BitbasePosition& position, Bitboard occupied, int skipped) const;
+	bool isLegal(const BitbasePosition& position) const;
+	int getWeakValue(BitbasePosition position) const;
+	int getPromotionValue(const BitbasePosition& position) const;
+	void setValue(BitbasePosition position, size_t index, int value, std::vector<uint32_t>& resolved);
+public:
+	BitbaseGenerator(const BitbaseTable& table, std::vector<uint8_t>& values, const uint8_t* queens, const uint8_t* rooks) :
+		table(table), values(values), promotions{ queens, rooks } {}
+	void generate();
+};
+
+Bitboard BitbaseGenerator::getOccupied(const BitbasePosition& position) const {
+	Bitboard occupied = getSquareMask(position.strongKing) | getSquareMask(position.weakKing);
+	for (int i = 0; i < table.pieceCount; i++) {
+		occupied |= getSquareMask(position.pieces[i]);
+	}
+	return occupied;
+}
+
+Bitboard BitbaseGenerator::getStrongAttacks(const BitbasePosition& position, Bitboard occupied, int skipped) const {
+	Bitboard attacks = getKingAttacks(position.strongKing);
+	for (int i = 0; i < table.pieceCount; i++) {
+		if (i != skipped) {
+			attacks |= getPieceAttacks(table.pieces[i], position.pieces[i], occupied);
+		}
+	}
+	return attacks;
+}
+
+bool BitbaseGenerator::isLegal(const BitbasePosition& position) const {
+	Bitboard occupied = getOccupied(position);
+	if (popCount(occupied) != table.pieceCount + 2 || (getKingAttacks(position.strongKing) & getSquareMask(position.weakKing))) {
+		return false;
+	}
+	for (int i = 0; i < table.pieceCount; i++) {
+		if (table.pieces[i] == PieceType::PAWN && (position.pieces[i] < BOARD_WIDTH || position.pieces[i] >= SQUARE_COUNT - BOARD_WIDTH)) {
+			return false;
+		}
+	}
+	return position.weakToMove || !(getStrongAttacks(position, occupied, -1) & getSquareMask(position.weakKing));
+}
+
+// Zero unless every weak king move is already known to lose
+int BitbaseGenerator::getWeakValue(BitbasePosition position) const {
+	// The king doesn't block attacks along the line it is fleeing
+	Bitboard occupied = getOccupied(position) ^ getSquareMask(position.weakKing);
+	Bitboard targets = getKingAttacks(position.weakKing) & ~getKingAttacks(position.strongKing);
+	int from = position.weakKing, worst = 0;
+	bool moved = false;
+	while (targets) {
+		int to = popLowestSquare(targets);
+		int captured = -1;
+		for (int i = 0; i < table.pieceCount; i++) {
+			captured = position.pieces[i] == to ? i : captured;
+		}
+		if (getStrongAttacks(position, occupied, captured) & getSquareMask(to)) {
+			continue;
+		}
+		// A lone piece can't mate, so any capture draws
+		if (captured >= 0) {
+			return 0;
+		}
+		moved = true;
+		position.weakToMove = false;
+		position.weakKing = to;
+		int value = values[getIndex(table, position)];
+		position.weakToMove = true;
+		position.weakKing = from;
+		if (value == 0) {
+			return 0;
+		}
+		worst = std::max(worst, value);
+	}
+	if (moved) {
+		return worst + 1;
+	}
+	// Mated, or stalemated
+	return getStrongAttacks(position, occupied, -1) & getSquareMask(from) ? 1 : 0;
+}
+
+// The fastest mate reached by promoting to a queen or rook, zero if none
+int BitbaseGenerator::getPromotionValue(const BitbasePosition& position) const {
+	int pawn = position.pieces[0];
+	int target = pawn - BOARD_WIDTH;
+	if (!table.hasPawns() || target >= BOARD_WIDTH || (getOccupied(position) & getSquareMask(target))) {
+		return 0;
+	}
+	int best = 0;
+	for (int i = 0; i < 2; i++) {
+		const BitbaseTable& promoted = TABLES[i == 0 ? KQK : KRK];
+		BitbasePosition next = position;
+		next.weakToMove = true;
+		next.pieces[0] = target;
+		int value = promotions[i][getIndex(promoted, next)];
+		if (value != 0 && (best == 0 || value + 1 < best)) {
+			best = value + 1;
+		}
+	}
+	return best;
+}
+
+// A pawnless position with the strong king on the long diagonal is stored
+// twice, once transposed, and both copies have to be resolved together
+void BitbaseGenerator::setValue(BitbasePosition position, size_t index, int value, std::vector<uint32_t>& resolved) {
+	values[index] = static_cast<uint8_t>(value);
+	resolved.push_back(static_cast<uint32_t>(index));
+	if (table.hasPawns()) {
+		return;
+	}
+	int symmetry = getSymmetry(position.strongKing);
+	position.strongKing = applySymmetry(position.strongKing, symmetry);
+	if (!isOnDiagonal(position.strongKing)) {
+		return;
+	}
+	position.weakKing = applySymmetry(applySymmetry(position.weakKing, symmetry), 4);
+	for (int i = 0; i < table.pieceCount; i++) {
+		position.pieces[i] = applySymmetry(applySymmetry(position.pieces[i], symmetry), 4);
+	}
+	size_t twin = getIndex(table, position);
+	if (values[twin] == 0) {
+		values[twin] = static_cast<uint8_t>(value);
+		resolved.push_back(static_cast<uint32_t>(twin));
+	}
+}
+
+void BitbaseGenerator::generate() {
+	size_t size = table.getSize();
+	values.assign(size, 0);
+	std::vector<uint32_t> current, next;
+	std::vector<std::vector<uint32_t>> promotionWins(256);
+	for (size_t index = 0; index < size; index++) {
+		BitbasePosition position = getPosition(table, index);
+		if (!isLegal(position) || values[index] != 0) {
+			continue;
+		}
+		if (position.weakToMove && getWeakValue(position) == 1) {
+			setValue(position, index, 1, current);
+		}
+		else if (!position.weakToMove) {
+			int value = getPromotionValue(position);
+			if (value != 0) {
+				promotionWins[value].push_back(static_cast<uint32_t>(index));
+			}
+		}
+	}
+	for (int value = 1; value < 254 && !generationCancelled.load(std::memory_order_relaxed); value++) {
+		next.clear();
+		for (uint32_t index : current) {
+			BitbasePosition position = getPosition(table, index);
+			Bitboard occupied = getOccupied(position);
+			if (position.weakToMove) {
+				// The strong side takes back its last move
+				BitbasePosition previous = position;
+				previous.weakToMove = false;
+				Bitboard origins = getKingAttacks(position.strongKing) & ~occupied & ~getKingAttacks(position.weakKing);
+				while (origins) {
+					previous.strongKing = popLowestSquare(origins);
+					size_t previousIndex = getIndex(table, previous);
+					if (values[previousIndex] == 0 && isLegal(previous)) {
+						setValue(previous, previousIndex, value + 1, next);
+					}
+				}
+				previous.strongKing = position.strongKing;
+				for (int i = 0; i < table.pieceCount; i++) {
+					int square = position.pieces[i];
+					if (table.pieces[i] == PieceType::PAWN) {
+						origins = 0;
+						if (square < SQUARE_COUNT - 2 * BOARD_WIDTH && !(occupied & getSquareMask(square + BOARD_WIDTH))) {
+							origins |= getSquareMask(square + BOARD_WIDTH);
+							if (square / BOARD_WIDTH == 4 && !(occupied & getSquareMask(square + 2 * BOARD_WIDTH))) {
+								origins |= getSquareMask(square + 2 * BOARD_WIDTH);
+							}
+						}
+					}
+					else {
+						origins = getPieceAttacks(table.pieces[i], square, occupied) & ~occupied;
+					}
+					while (origins) {
+						previous.pieces[i] = popLowestSquare(origins);
+						size_t previousIndex = getIndex(table, previous);
+						if (values[previousIndex] == 0 && isLegal(previous)) {
+							setValue(previous, previousIndex, value + 1, next);
+						}
+					}
+					previous.pieces[i] = square;
+				}
+			}
+			else {
+				// The weak king takes back its last move
+				BitbasePosition previous = position;
+				previous.weakToMove = true;
+				Bitboard origins = getKingAttacks(position.weakKing) & ~occupied & ~getKingAttacks(position.strongKing);
+				while (origins) {
+					previous.weakKing = popLowestSquare(origins);
+					size_t previousIndex = getIndex(table, previous);
+					if (values[previousIndex] == 0 && isLegal(previous)) {
+						int result = getWeakValue(previous);
+						if (result != 0) {
+							setValue(previous, previousIndex, result, next);
+						}
+					}
+				}
+			}
+		}
+		for (uint32_t index : promotionWins[value + 1]) {
+			if (values[index] == 0) {
+				setValue(getPosition(table, index), index, value + 1, next);
+			}
+		}
+		current.swap(next);
+	}
+}
+
+size_t getTablesSize() {
+	size_t size = 0;
+	for (const BitbaseTable& table : TABLES) {
+		size += table.getSize();
+	}
+	return size;
+}
+
+// Generates into memory and tries to leave the cache behind for the next run.
+// Gives up without writing anything once cancelled.
+bool generateBitbases(const std::string& path, bool verbose) {
+	generatedTables.assign(sizeof(BITBASE_MAGIC) + getTablesSize(), 0);
+	std::memcpy(generatedTables.data(), BITBASE_MAGIC, sizeof(BITBASE_MAGIC));
+	size_t offset = sizeof(BITBASE_MAGIC);
+	std::vector<uint8_t> values;
+	for (int i = 0; i < TABLE_COUNT; i++) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BitbaseGenerator generator(TABLES[i], values, tables[KQK], tables[KRK]);
+		generator.generate();
+		if (generationCancelled) {
+			return false;
+		}
+		std::memcpy(generatedTables.data() + offset, values.data(), values.size());
+		tables[i] = generatedTables.data() + offset;
+		offset += values.size();
+		if (verbose) {
+			size_t wins = 0;
+			int longest = 0;
+			for (size_t index = 0; index < values.size(); index++) {
+				wins += values[index] != 0 ? 1 : 0;
+				longest = std::max<int>(longest, values[index]);
+			}
+			std::cout << std::left << std::setw(6) << TABLES[i].name << std::right << std::setw(10) << values.size() << " positions"
+				<< std::setw(10) << wins << " mates, longest " << std::setw(3) << std::max(longest - 1, 0) << " plies in " << std::fixed
+				<< std::setprecision(2) << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s" << std::endl;
+		}
+	}
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(generatedTables.data()), static_cast<std::streamsize>(generatedTables.size()));
+	if (verbose) {
+		std::cout << (file ? "Wrote " : "Could not write ") << path << std::endl;
+	}
+	return true;
+}
+
+void loadBitbases() {
+	if (bitbasesLoaded || generationThread.joinable()) {
+		return;
+	}
+	if (bitbaseFile.open(BITBASE_PATH) && bitbaseFile.getSize() == sizeof(BITBASE_MAGIC) + getTablesSize() &&
+		std::memcmp(bitbaseFile.getData(), BITBASE_MAGIC, sizeof(BITBASE_MAGIC)) == 0) {
+		size_t offset = sizeof(BITBASE_MAGIC);
+		for (int i = 0; i < TABLE_COUNT; i++) {
+			tables[i] = bitbaseFile.getData() + offset;
+			offset += TABLES[i].getSize();
+		}
+		bitbasesLoaded = true;
+		return;
+	}
+	bitbaseFile.close();
+	generationCancelled = false;
+	generationThread = std::thread([]() {
+		if (generateBitbases(BITBASE_PATH, false)) {
+			bitbasesLoaded = true;
+		}
+	});
+}
+
+bool isBitbaseLoaded() {
+	return bitbasesLoaded;
+}
+
+void stopBitbaseGeneration() {
+	generationCancelled = true;
+	if (generationThread.joinable()) {
+		generationThread.join();
+	}
+}
+
+bool probeBitbase(const Game& game, BitbaseEntry& entry) {
+	Bitboard occupied = game.getOccupied();
+	if (popCount(occupied) > 4 || game.getCastlingRights() != 0) {
+		return false;
+	}
+	PieceColor strong = PieceColor::WHITE;
+	if (game.getPieces(strong) == game.getPieces(strong, PieceType::KING)) {
+		strong = PieceColor::BLACK;
+	}
+	PieceColor weak = getOpposite(strong);
+	if (game.getPieces(weak) != game.getPieces(weak, PieceType::KING)) {
+		return false;
+	}
+	int pieceCount = popCount(game.getPieces(strong)) - 1;
+	int found = -1;
+	for (int i = 0; i < TABLE_COUNT && found < 0; i++) {
+		found = TABLES[i].pieceCount == pieceCount && (pieceCount < 2 || game.getPieces(strong, TABLES[i].pieces[1])) &&
+			game.getPieces(strong, TABLES[i].pieces[0]) ? i : -1;
+	}
+	if (found < 0 || !bitbasesLoaded.load(std::memory_order_acquire)) {
+		return false;
+	}
+	const BitbaseTable& table = TABLES[found];
+	// Black playing the strong side is looked up flipped to white
+	int flip = strong == PieceColor::WHITE ? 0 : SQUARE_COUNT - BOARD_WIDTH;
+	BitbasePosition position;
+	position.weakToMove = game.getCurrentTurn() == weak;
+	position.strongKing = getLowestSquare(game.getPieces(strong, PieceType::KING)) ^ flip;
+	position.weakKing = getLowestSquare(game.getPieces(weak, PieceType::KING)) ^ flip;
+	for (int i = 0; i < table.pieceCount; i++) {
+		position.pieces[i] = getLowestSquare(game.getPieces(strong, table.pieces[i])) ^ flip;
+	}
+	int value = tables[found][getIndex(table, position)];
+	entry.result = value == 0 ? BitbaseResult::DRAW : position.weakToMove ? BitbaseResult::LOSS : BitbaseResult::WIN;
+	entry.matePlies = std::max(value - 1, 0);
+	return true;
+}
+
+int runBitbaseGenerator(const std::string& path) {
+	return generateBitbases(path, true) ? 0 : 1;
+}
\ No newline at end of file
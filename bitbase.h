@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+class Game;
+
+static constexpr const char* BITBASE_PATH = "bitbases.bin";
+
+// From the point of view of the side to move
+enum class BitbaseResult {
+	DRAW, WIN, LOSS
+};
+
+struct BitbaseEntry {
+	BitbaseResult result;
+	// Plies until mate with best play from both sides, zero for draws
+	int matePlies;
+};
+
+// Exact distance to mate for KQK, KRK, KPK and KBNK with either side to move.
+// The tables are built by retrograde analysis and cached in a file next to the
+// engine, which later runs map read-only.
+//
+// Maps the cache, or starts building the tables on a background thread when
+// there is none, so no search ever waits on the few seconds that takes
+void loadBitbases();
+bool isBitbaseLoaded();
+// Abandons a build still running, before the program exits
+void stopBitbaseGeneration();
+// Misses until the tables are loaded
+bool probeBitbase(const Game& game, BitbaseEntry& entry);
+// Builds every table from scratch and rewrites the cache, reporting as it goes
+int runBitbaseGenerator(const std::string& path);
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include <cstddef>
+
+#include "bitboard.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+SlidingAttacks BISHOP_MAGICS[SQUARE_COUNT], ROOK_MAGICS[SQUARE_COUNT];
+bool pextEnabled = false;
+
+// Every square gets one slot per subset of its blocker mask, which adds up to
+// 5248 bishop and 102400 rook entries
+Bitboard bishopAttacks[5248], rookAttacks[102400];
+
+Bitboard slide(int square, Bitboard occupied, int right, int up) {
+	Bitboard result = 0;
+	int x = square % BOARD_WIDTH + right, y = square / BOARD_WIDTH - up;
+	while (x >= 0 && x < BOARD_WIDTH && y >= 0 && y < BOARD_HEIGHT) {
+		Bitboard mask = getSquareMask(getSquare(x, y));
+		result |= mask;
+		if (occupied & mask) {
+			break;
+		}
+		x += right;
+		y -= up;
+	}
+	return result;
+}
+
+Bitboard slideAll(int square, Bitboard occupied, bool rook) {
+	if (rook) {
+		return slide(square, occupied, 1, 0) | slide(square, occupied, -1, 0) |
+			slide(square, occupied, 0, 1) | slide(square, occupied, 0, -1);
+	}
+	return slide(square, occupied, 1, 1) | slide(square, occupied, -1, 1) |
+		slide(square, occupied, 1, -1) | slide(square, occupied, -1, -1);
+}
+
+bool hasFastPext() {
+	unsigned int vendor[3] = {}, family = 0, features = 0;
+#if defined(_MSC_VER)
+	int registers[4];
+	__cpuid(registers, 0);
+	if (registers[0] < 7) {
+		return false;
+	}
+	vendor[0] = registers[1];
+	vendor[1] = registers[3];
+	vendor[2] = registers[2];
+	__cpuid(registers, 1);
+	family = registers[0];
+	__cpuidex(registers, 7, 0);
+	features = registers[1];
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	unsigned int eax, ebx, ecx, edx;
+	if (__get_cpuid_max(0, nullptr) < 7) {
+		return false;
+	}
+	__cpuid(0, eax, vendor[0], vendor[2], vendor[1]);
+	__cpuid(1, family, ebx, ecx, edx);
+	__cpuid_count(7, 0, eax, features, ecx, edx);
+#else
+	return false;
+#endif
+	if (!(features & (1 << 8))) {
+		return false;
+	}
+	// AMD only implemented PEXT in microcode before Zen 3, which makes it far
+	// slower than a magic multiply
+	bool amd = vendor[0] == 0x68747541 && vendor[1] == 0x69746E65 && vendor[2] == 0x444D4163;
+	unsigned int fullFamily = ((family >> 8) & 0xF) + ((family >> 20) & 0xFF);
+	return !amd || fullFamily >= 0x19;
+}
+
+uint64_t nextRandom(uint64_t& state) {
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 2685821657736338717ULL;
+}
+
+// Fills each square's slice of the table for the currently selected indexing
+// scheme, searching for a magic number first if the square doesn't have one
+void fillSlidingAttacks(SlidingAttacks* entries, Bitboard* table, bool rook) {
+	static Bitboard occupancies[4096], references[4096];
+	static int epochs[4096];
+	uint64_t state = rook ? 0x9E3779B97F4A7C15ULL : 0xD1B54A32D192ED03ULL;
+	for (int square = 0; square < SQUARE_COUNT; square++) {
+		SlidingAttacks& entry = entries[square];
+		int x = square % BOARD_WIDTH, y = square / BOARD_WIDTH;
+		Bitboard edges = ((getRowMask(0) | getRowMask(BOARD_HEIGHT - 1)) & ~getRowMask(y)) |
+			((LEFT_COLUMN | RIGHT_COLUMN) & ~getColumnMask(x));
+		entry.mask = slideAll(square, 0, rook) & ~edges;
+		entry.shift = SQUARE_COUNT - popCount(entry.mask);
+		entry.attacks = table;
+		int size = 0;
+		Bitboard subset = 0;
+		do {
+			occupancies[size] = subset;
+			references[size++] = slideAll(square, subset, rook);
+			subset = (subset - entry.mask) & entry.mask;
+		} while (subset);
+		table += size;
+		if (pextEnabled) {
+			for (int i = 0; i < size; i++) {
+				entry.attacks[extractBits(occupancies[i], entry.mask)] = references[i];
+			}
+			continue;
+		}
+		for (int i = 0; i < size; i++) {
+			epochs[i] = 0;
+		}
+		int epoch = 0;
+		bool found = entry.magic != 0;
+		do {
+			if (!found) {
+				do {
+					entry.magic = nextRandom(state) & nextRandom(state) & nextRandom(state);
+				} while (popCount((entry.mask * entry.magic) >> 56) < 6);
+			}
+			epoch++;
+			found = true;
+			for (int i = 0; i < size && found; i++) {
+				size_t index = static_cast<size_t>(((occupancies[i] & entry.mask) * entry.magic) >> entry.shift);
+				if (epochs[index] < epoch) {
+					epochs[index] = epoch;
+					entry.attacks[index] = references[i];
+				}
+				else if (entry.attacks[index] != references[i]) {
+					found = false;
+				}
+			}
+		} while (!found);
+	}
+}
+
+void initSlidingAttacks() {
+	fillSlidingAttacks(BISHOP_MAGICS, bishopAttacks, false);
+	fillSlidingAttacks(ROOK_MAGICS, rookAttacks, true);
+}
+
+bool isPextSupported() {
+	static const bool supported = hasFastPext();
+	return supported;
+}
+
+bool isPextEnabled() {
+	return pextEnabled;
+}
+
+void setPextEnabled(bool enabled) {
+	pextEnabled = enabled && isPextSupported();
+	initSlidingAttacks();
+}
+
+struct SlidingAttacksInitializer {
+	SlidingAttacksInitializer() {
+		setPextEnabled(true);
+	}
+} slidingAttacksInitializer;
\ No newline at end of file
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "constants.h"
+#include "point.h"
+
+typedef uint64_t Bitboard;
+
+static constexpr int SQUARE_COUNT = BOARD_WIDTH * BOARD_HEIGHT;
+static constexpr int COLOR_COUNT = 2;
+static constexpr int NO_SQUARE = SQUARE_COUNT;
+
+static constexpr Bitboard LEFT_COLUMN = 0x0101010101010101ULL;
+static constexpr Bitboard RIGHT_COLUMN = LEFT_COLUMN << (BOARD_WIDTH - 1);
+static constexpr Bitboard TOP_ROW = 0xFFULL;
+
+// Squares are numbered in the same order the board is drawn, so square 0 is
+// the top left corner (a8) and square 63 is the bottom right corner (h1).
+inline constexpr int getSquare(int x, int y) { return y * BOARD_WIDTH + x; }
+inline int getSquare(Point point) { return getSquare(point.x, point.y); }
+inline Point getPoint(int square) { return Point(square % BOARD_WIDTH, square / BOARD_WIDTH); }
+inline constexpr Bitboard getSquareMask(int square) { return 1ULL << square; }
+inline constexpr Bitboard getColumnMask(int x) { return LEFT_COLUMN << x; }
+inline constexpr Bitboard getRowMask(int y) { return TOP_ROW << (y * BOARD_WIDTH); }
+
+inline constexpr Bitboard shiftUp(Bitboard board) { return board >> BOARD_WIDTH; }
+inline constexpr Bitboard shiftDown(Bitboard board) { return board << BOARD_WIDTH; }
+inline constexpr Bitboard shiftLeft(Bitboard board) { return (board >> 1) & ~RIGHT_COLUMN; }
+inline constexpr Bitboard shiftRight(Bitboard board) { return (board << 1) & ~LEFT_COLUMN; }
+
+inline int popCount(Bitboard board) {
+#if defined(_MSC_VER) && defined(_WIN64)
+	return static_cast<int>(__popcnt64(board));
+#elif defined(__GNUC__)
+	return __builtin_popcountll(board);
+#else
+	int count = 0;
+	while (board) {
+		board &= board - 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+inline int getLowestSquare(Bitboard board) {
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanForward64(&index, board);
+	return static_cast<int>(index);
+#elif defined(__GNUC__)
+	return __builtin_ctzll(board);
+#else
+	int index = 0;
+	while (!(board & 1)) {
+		board >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+inline int popLowestSquare(Bitboard& board) {
+	int square = getLowestSquare(board);
+	board &= board - 1;
+	return square;
+}
+
+inline uint64_t extractBits(Bitboard board, Bitboard mask) {
+#if defined(_MSC_VER) && defined(_WIN64)
+	return _pext_u64(board, mask);
+#elif defined(__GNUC__) && defined(__x86_64__)
+	// Inline assembly rather than the intrinsic so callers don't need to be
+	// compiled for BMI2, this only runs once the CPU has been checked for it
+	uint64_t result;
+	__asm__("pextq %2, %1, %0" : "=r"(result) : "r"(board), "r"(mask));
+	return result;
+#else
+	uint64_t result = 0;
+	for (uint64_t bit = 1; mask; bit <<= 1) {
+		if (board & mask & (0 - mask)) {
+			result |= bit;
+		}
+		mask &= mask - 1;
+	}
+	return result;
+#endif
+}
+
+struct AttackTable {
+	Bitboard squares[SQUARE_COUNT];
+};
+
+inline constexpr AttackTable createKnightAttacks() {
+	AttackTable table = {};
+	for (int square = 0; square < SQUARE_COUNT; square++) {
+		Bitboard knight = getSquareMask(square);
+		Bitboard one = shiftLeft(knight) | shiftRight(knight);
+		Bitboard two = shiftLeft(shiftLeft(knight)) | shiftRight(shiftRight(knight));
+		table.squares[square] = shiftUp(shiftUp(one)) | shiftDown(shiftDown(one)) | shiftUp(two) | shiftDown(two);
+	}
+	return table;
+}
+
+inline constexpr AttackTable createKingAttacks() {
+	AttackTable table = {};
+	for (int square = 0; square < SQUARE_COUNT; square++) {
+		Bitboard king = getSquareMask(square);
+		Bitboard row = king | shiftLeft(king) | shiftRight(king);
+		table.squares[square] = (row | shiftUp(row) | shiftDown(row)) & ~king;
+	}
+	return table;
+}
+
+inline constexpr AttackTable createPawnAttacks(int color) {
+	AttackTable table = {};
+	for (int square = 0; square < SQUARE_COUNT; square++) {
+		Bitboard sides = shiftLeft(getSquareMask(square)) | shiftRight(getSquareMask(square));
+		table.squares[square] = color == 0 ? shiftUp(sides) : shiftDown(sides);
+	}
+	return table;
+}
+
+static constexpr AttackTable KNIGHT_ATTACKS = createKnightAttacks();
+static constexpr AttackTable KING_ATTACKS = createKingAttacks();
+static constexpr AttackTable PAWN_ATTACKS[COLOR_COUNT] = { createPawnAttacks(0), createPawnAttacks(1) };
+
+// Sliding attacks are looked up by the occupancy of the squares that can block
+// them. The occupancy is turned into a table index either with a magic
+// multiply or, on CPUs with fast BMI2, with a single PEXT instruction.
+struct SlidingAttacks {
+	Bitboard mask;
+	Bitboard magic;
+	Bitboard* attacks;
+	int shift;
+};
+
+extern SlidingAttacks BISHOP_MAGICS[SQUARE_COUNT], ROOK_MAGICS[SQUARE_COUNT];
+extern bool pextEnabled;
+
+inline Bitboard lookupSlidingAttacks(const SlidingAttacks& entry, Bitboard occupied) {
+	if (pextEnabled) {
+		return entry.attacks[extractBits(occupied, entry.mask)];
+	}
+	return entry.attacks[((occupied & entry.mask) * entry.magic) >> entry.shift];
+}
+
+inline Bitboard getPawnAttacks(int color, int square) { return PAWN_ATTACKS[color].squares[square]; }
+inline Bitboard getKnightAttacks(int square) { return KNIGHT_ATTACKS.squares[square]; }
+inline Bitboard getKingAttacks(int square) { return KING_ATTACKS.squares[square]; }
+inline Bitboard getBishopAttacks(int square, Bitboard occupied) { return lookupSlidingAttacks(BISHOP_MAGICS[square], occupied); }
+inline Bitboard getRookAttacks(int square, Bitboard occupied) { return lookupSlidingAttacks(ROOK_MAGICS[square], occupied); }
+inline Bitboard getQueenAttacks(int square, Bitboard occupied) {
+	return getBishopAttacks(square, occupied) | getRookAttacks(square, occupied);
+}
+
+bool isPextSupported();
+bool isPextEnabled();
+void setPextEnabled(bool enabled);
\ No newline at end of file
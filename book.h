@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mappedfile.h"
+#include "move.h"
+
+class Game;
+
+static constexpr int POLYGLOT_KEY_COUNT = 781;
+
+enum class BookSelection {
+	BEST, WEIGHTED
+};
+
+struct BookMove {
+	Move move;
+	int weight;
+};
+
+// The key Polyglot books are sorted by, built from the 781 Random64 numbers
+// published with the format
+uint64_t getPolyglotKey(const Game& game);
+
+// A Polyglot .bin book mapped read-only into memory. Entries are sorted by key,
+// so probing is a binary search straight over the mapping with nothing loaded
+// up front, and every process mapping the same file shares its pages.
+class OpeningBook {
+private:
+	MappedFile file;
+public:
+	bool open(const std::string& path) { return file.open(path); }
+	void close() { file.close(); }
+	bool isOpen() const { return file.isOpen(); }
+	size_t getEntryCount() const;
+	// The legal book moves for the position, best first
+	void getMoves(Game& game, std::vector<BookMove>& moves) const;
+	// None when the position isn't in the book
+	Move probe(Game& game, BookSelection selection) const;
+};
\ No newline at end of file
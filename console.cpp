@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <string>
 
@@ -44,12 +46,26 @@ void Console::bufferln() {
 }
 
 void Console::flush() {
-	print(consoleBuffer);
+	present(consoleBuffer);
 	consoleBuffer.clear();
 }
 
+void Console::write(const std::string& text) {
+	std::cout << text << std::flush;
+}
+
+void Console::refresh() {
+	write(screen.render());
+}
+
+void Console::present(const std::string& frame) {
+	screen.clear();
+	screen.writeText(0, 0, frame);
+	refresh();
+}
+
 void Console::waitForEnter() {
-	while (getDirectionalInput() != DirectionalInput::ENTER) {}
+	while (getDirectionalInput() != DirectionalInput::ENTER && !closed) {}
 }
 
 DirectionalInput Console::getDirectionalInput() {
@@ -57,23 +73,63 @@ DirectionalInput Console::getDirectionalInput() {
 }
 
 DirectionalInput Console::getDirectionalInput(bool allowEscape) {
+	DirectionalInput input;
+	while (!pollDirectionalInput(input, -1, allowEscape)) {}
+	return input;
+}
+
+bool Console::pollDirectionalInput(DirectionalInput& input, int timeout, bool allowEscape) {
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+	InputEvent event;
 	while (true) {
-		switch (getCharacter()) {
-		case 10: case 13:
-			return DirectionalInput::ENTER;
-		case 72: case 'w':
-			return DirectionalInput::UP;
-		case 80: case 's':
-			return DirectionalInput::DOWN;
-		case 75: case 'a':
-			return DirectionalInput::LEFT;
-		case 77: case 'd':
-			return DirectionalInput::RIGHT;
-		case 27:
+		int remaining = timeout < 0 ? -1 : std::max(0, static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+			deadline - std::chrono::steady_clock::now()).count()));
+		if (!pollInput(event, remaining)) {
+			return false;
+		}
+		switch (event.key) {
+		case InputKey::ENTER:
+			input = DirectionalInput::ENTER;
+			return true;
+		case InputKey::UP:
+			input = DirectionalInput::UP;
+			return true;
+		case InputKey::DOWN:
+			input = DirectionalInput::DOWN;
+			return true;
+		case InputKey::LEFT:
+			input = DirectionalInput::LEFT;
+			return true;
+		case InputKey::RIGHT:
+			input = DirectionalInput::RIGHT;
+			return true;
+		case InputKey::CLOSED:
+			input = DirectionalInput::ESCAPE;
+			return true;
+		case InputKey::ESCAPE:
 			if (allowEscape) {
-				return DirectionalInput::ESCAPE;
+				input = DirectionalInput::ESCAPE;
+				return true;
 			}
 			break;
+		case InputKey::CHARACTER:
+			switch (event.character) {
+			case 'w':
+				input = DirectionalInput::UP;
+				return true;
+			case 's':
+				input = DirectionalInput::DOWN;
+				return true;
+			case 'a':
+				input = DirectionalInput::LEFT;
+				return true;
+			case 'd':
+				input = DirectionalInput::RIGHT;
+				return true;
+			}
+			break;
+		default:
+			break;
 		}
 	}
 }
@@ -2,17 +2,40 @@
 
 #include <string>
 
+#include "screen.h"
+
 enum class DirectionalInput {
 	UP, DOWN, LEFT, RIGHT, ENTER, ESCAPE
 };
 
+enum class InputKey {
+	CHARACTER, UP, DOWN, LEFT, RIGHT, ENTER, ESCAPE, OTHER,
+	// The input has ended, nothing more will ever be typed
+	CLOSED
+};
+
+struct InputEvent {
+	InputKey key;
+	// Lowercase, for character keys
+	char character;
+};
+
 class Console {
+protected:
+	Screen screen;
+	bool closed = false;
 public:
 	virtual ~Console() = 0;
-	virtual char getCharacter() = 0;
+	// Waits up to the timeout in milliseconds for a key press, or forever when
+	// the timeout is negative. Returns false if none came. Once the input has
+	// ended, every call returns CLOSED at once.
+	virtual bool pollInput(InputEvent& event, int timeout) = 0;
+	bool isClosed() const { return closed; }
 	virtual void clear() = 0;
 	virtual void init() = 0;
 	virtual void debug(std::string text) = 0;
+	// Sends the text to the terminal at once, bypassing any buffering
+	virtual void write(const std::string& text);
 
 	void print(const char* text);
 	void println(const char* text);
@@ -24,26 +47,45 @@ public:
 	void bufferln(std::string text);
 	void bufferln(const char* text);
 	void bufferln();
+	// Shows the buffered text as a whole frame
 	void flush();
 
+	Screen& getScreen() { return screen; }
+	// Shows the frame drawn on the screen, repainting only what changed
+	void refresh();
+	void present(const std::string& frame);
+
+	// Every prompt reads as escaped once the input has ended, so the menus
+	// unwind back out to the main menu and the program exits normally
 	void waitForEnter();
 	DirectionalInput getDirectionalInput();
 	DirectionalInput getDirectionalInput(bool allowEscape);
+	bool pollDirectionalInput(DirectionalInput& input, int timeout, bool allowEscape);
 };
 
 class ConsoleWindows : public Console {
 public:
-	char getCharacter();
+	bool pollInput(InputEvent& event, int timeout);
 	void clear();
 	void init();
 	void debug(std::string text);
 };
 
+// Puts the terminal in raw mode for the whole run and puts it back on exit,
+// including exits by signal
 class ConsoleBash : public Console {
-	char getCharacter();
+private:
+	// Bytes read but not yet decoded into key presses
+	std::string pending;
+	bool readInput(int timeout);
+	bool decodeInput(InputEvent& event, bool complete);
+public:
+	~ConsoleBash();
+	bool pollInput(InputEvent& event, int timeout);
 	void clear();
 	void init();
 	void debug(std::string text);
+	void write(const std::string& text);
 };
 
 Console& getConsole();
\ No newline at end of file
@@ -1,4 +1,8 @@
+#include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
 
 #include "console.h"
 
@@ -7,30 +11,168 @@
 #endif
 
 #ifdef bash
-#include <stdio.h>
+#include <csignal>
+#include <poll.h>
 #include <unistd.h>
 #include <termios.h>
 #endif
 
-char ConsoleBash::getCharacter() {
-	char result = 0;
+// How long the rest of an escape code may take to arrive after the escape
+// itself before it counts as the escape key on its own
+static constexpr int ESCAPE_DELAY = 25;
+
+#ifdef bash
+static struct termios originalTerminal;
+static volatile sig_atomic_t rawMode = 0;
+
+void restoreTerminal() {
+	if (rawMode) {
+		tcsetattr(STDIN_FILENO, TCSANOW, &originalTerminal);
+		rawMode = 0;
+	}
+}
+
+void handleTerminationSignal(int signal) {
+	restoreTerminal();
+	std::signal(signal, SIG_DFL);
+	std::raise(signal);
+}
+#endif
+
+ConsoleBash::~ConsoleBash() {
 #ifdef bash
-	struct termios old_tio, new_tio;
-	tcgetattr(STDIN_FILENO, &old_tio);
-	new_tio = old_tio;
-	new_tio.c_lflag &= (~ICANON & ~ECHO);
-	tcsetattr(STDIN_FILENO, TCSANOW, &new_tio);
-	result = getchar();
-	tcsetattr(STDIN_FILENO, TCSANOW, &old_tio);
+	restoreTerminal();
 #endif
-	return std::isalpha(result) ? std::tolower(result) : result;
 }
 
-void ConsoleBash::init() {}
+void ConsoleBash::init() {
+#ifdef bash
+	if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &originalTerminal) != 0) {
+		return;
+	}
+	struct termios raw = originalTerminal;
+	raw.c_lflag &= ~(ICANON | ECHO);
+	raw.c_cc[VMIN] = 1;
+	raw.c_cc[VTIME] = 0;
+	if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) != 0) {
+		return;
+	}
+	rawMode = 1;
+	std::atexit(restoreTerminal);
+	for (int signal : { SIGINT, SIGTERM, SIGHUP, SIGQUIT }) {
+		std::signal(signal, handleTerminationSignal);
+	}
+#endif
+}
+
+// False if nothing arrived in time
+bool ConsoleBash::readInput(int timeout) {
+#ifdef bash
+	struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+	if (poll(&input, 1, timeout) <= 0) {
+		return false;
+	}
+	char bytes[64];
+	ssize_t count = read(STDIN_FILENO, bytes, sizeof(bytes));
+	if (count == 0) {
+		// Nothing can ever be typed again
+		closed = true;
+		return false;
+	}
+	if (count < 0) {
+		return false;
+	}
+	pending.append(bytes, static_cast<size_t>(count));
+	return true;
+#else
+	return false;
+#endif
+}
+
+// Takes one key press off the front of the pending input. Unless complete is
+// set, an escape code cut short might still be arriving, so it is left alone.
+bool ConsoleBash::decodeInput(InputEvent& event, bool complete) {
+	if (pending.empty()) {
+		return false;
+	}
+	size_t length = 1;
+	event.character = 0;
+	char first = pending[0];
+	if (first == 27) {
+		bool introduced = pending.size() > 1 && (pending[1] == '[' || pending[1] == 'O');
+		size_t end = 2;
+		while (introduced && end < pending.size() && (pending[end] < 0x40 || pending[end] > 0x7E)) {
+			end++;
+		}
+		if (!complete && (pending.size() == 1 || (introduced && end == pending.size()))) {
+			return false;
+		}
+		event.key = InputKey::ESCAPE;
+		if (introduced && end < pending.size()) {
+			length = end + 1;
+			switch (pending[end]) {
+			case 'A': event.key = InputKey::UP; break;
+			case 'B': event.key = InputKey::DOWN; break;
+			case 'C': event.key = InputKey::RIGHT; break;
+			case 'D': event.key = InputKey::LEFT; break;
+			default: event.key = InputKey::OTHER; break;
+			}
+		}
+	}
+	else if (first == '\n' || first == '\r') {
+		event.key = InputKey::ENTER;
+	}
+	else {
+		event.key = InputKey::CHARACTER;
+		event.character = static_cast<char>(std::tolower(static_cast<unsigned char>(first)));
+	}
+	pending.erase(0, length);
+	return true;
+}
+
+bool ConsoleBash::pollInput(InputEvent& event, int timeout) {
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+	while (!decodeInput(event, false)) {
+		if (closed && pending.empty()) {
+			event.key = InputKey::CLOSED;
+			event.character = 0;
+			return true;
+		}
+		int remaining = timeout < 0 ? -1 : std::max(0, static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+			deadline - std::chrono::steady_clock::now()).count()));
+		if (!pending.empty()) {
+			remaining = ESCAPE_DELAY;
+		}
+		if (!readInput(remaining)) {
+			if (!pending.empty()) {
+				return decodeInput(event, true);
+			}
+			if (timeout >= 0 && std::chrono::steady_clock::now() >= deadline) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
 
 void ConsoleBash::clear() {
-	system("clear");
-	//std::cout << "\033[2J\033[1;1H";
+	write("\033[2J\033[1;1H");
+	screen.invalidate();
+}
+
+// One system call per frame, so the terminal never shows half of one
+void ConsoleBash::write(const std::string& text) {
+	std::cout.flush();
+#ifdef bash
+	size_t written = 0;
+	while (written < text.size()) {
+		ssize_t result = ::write(STDOUT_FILENO, text.data() + written, text.size() - written);
+		if (result <= 0) {
+			break;
+		}
+		written += static_cast<size_t>(result);
+	}
+#endif
 }
 
 void ConsoleBash::debug(std::string text) {}
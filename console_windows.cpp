@@ -10,15 +10,43 @@
 #include <conio.h>
 #endif
 
-char ConsoleWindows::getCharacter() {
-	char result = 0;
+bool ConsoleWindows::pollInput(InputEvent& event, int timeout) {
 #ifdef windows
-	result = -32;
-	while (result == -32) {
-		result = static_cast<char>(_getch());
+	ULONGLONG start = GetTickCount64();
+	while (!_kbhit()) {
+		if (timeout >= 0 && GetTickCount64() - start >= static_cast<ULONGLONG>(timeout)) {
+			return false;
+		}
+		Sleep(1);
 	}
+	int result = _getch();
+	event.character = 0;
+	// Arrow and function keys come as a prefix followed by a scan code
+	if (result == 0 || result == 224) {
+		switch (_getch()) {
+		case 72: event.key = InputKey::UP; break;
+		case 80: event.key = InputKey::DOWN; break;
+		case 75: event.key = InputKey::LEFT; break;
+		case 77: event.key = InputKey::RIGHT; break;
+		default: event.key = InputKey::OTHER; break;
+		}
+	}
+	else if (result == 13 || result == 10) {
+		event.key = InputKey::ENTER;
+	}
+	else if (result == 27) {
+		event.key = InputKey::ESCAPE;
+	}
+	else {
+		event.key = InputKey::CHARACTER;
+		event.character = static_cast<char>(std::tolower(result));
+	}
+	return true;
+#else
+	(void)event;
+	(void)timeout;
+	return false;
 #endif
-	return std::isalpha(result) ? std::tolower(result) : result;
 }
 
 void ConsoleWindows::init() {
@@ -30,6 +58,7 @@ void ConsoleWindows::init() {
 
 void ConsoleWindows::clear() {
 	system("cls");
+	screen.invalidate();
 }
 
 void ConsoleWindows::debug(std::string text) {
@@ -19,7 +19,7 @@ public:
 	Credits();
 	bool getCellAt(int x, int y);
 	void step();
-	void draw();
+	void draw(std::string footer);
 };
 
 void sleep(int time) {
@@ -30,8 +30,7 @@ void sleep(int time) {
 void displayCredits() {
 	Credits credits;
 	for (int i = 0; i < 20; i++) {
-		credits.draw();
-		getConsole().println("\n      Returning to main menu in " + std::to_string(10 - (i / 2)) + "...");
+		credits.draw("      Returning to main menu in " + std::to_string(10 - (i / 2)) + "...");
 		credits.step();
 		sleep(500);
 	}
@@ -88,7 +87,7 @@ void Credits::step() {
 	cells = updatedCells;
 }
 
-void Credits::draw() {
+void Credits::draw(std::string footer) {
 	std::vector<std::string> content;
 	std::string box;
 	std::string line1 = "     Program by Dylan (Quantum64)      ";
@@ -142,7 +141,7 @@ void Credits::draw() {
 		output += BOARD_EDGE_HORIZONTAL;
 	}
 	output += BOARD_CORNER_BOTTOM_RIGHT;
-	Console& out = getConsole();
-	out.clear();
-	out.println(output);
+	output += "\n\n";
+	output += footer;
+	getConsole().present(output);
 }
\ No newline at end of file
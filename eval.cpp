@@ -0,0 +1,146 @@
+#include <algorithm>
+
+#include "eval.h"
+#include "ai.h"
+#include "game.h"
+#include "pawns.h"
+#include "profile.h"
+
+Score PIECE_SQUARE_SCORES[COLOR_COUNT][PIECE_TYPE_COUNT][SQUARE_COUNT];
+
+static constexpr int PAWN_SCORE = 100;
+
+// Tables are laid out the way the board is drawn from white's side, so the
+// first row is the eighth rank. Black uses them mirrored.
+static constexpr int PAWN_MIDDLEGAME[SQUARE_COUNT] = {
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	 50,  50,  50,  50,  50,  50,  50,  50,
+	 10,  10,  20,  30,  30,  20,  10,  10,
+	  5,   5,  10,  25,  25,  10,   5,   5,
+	  0,   0,   0,  20,  20,   0,   0,   0,
+	  5,  -5, -10,   0,   0, -10,  -5,   5,
+	  5,  10,  10, -20, -20,  10,  10,   5,
+	  0,   0,   0,   0,   0,   0,   0,   0
+};
+
+static constexpr int PAWN_ENDGAME[SQUARE_COUNT] = {
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	 80,  80,  80,  80,  80,  80,  80,  80,
+	 50,  50,  50,  50,  50,  50,  50,  50,
+	 30,  30,  30,  30,  30,  30,  30,  30,
+	 20,  20,  20,  20,  20,  20,  20,  20,
+	 10,  10,  10,  10,  10,  10,  10,  10,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0
+};
+
+static constexpr int KNIGHT_TABLE[SQUARE_COUNT] = {
+	-50, -40, -30, -30, -30, -30, -40, -50,
+	-40, -20,   0,   0,   0,   0, -20, -40,
+	-30,   0,  10,  15,  15,  10,   0, -30,
+	-30,   5,  15,  20,  20,  15,   5, -30,
+	-30,   0,  15,  20,  20,  15,   0, -30,
+	-30,   5,  10,  15,  15,  10,   5, -30,
+	-40, -20,   0,   5,   5,   0, -20, -40,
+	-50, -40, -30, -30, -30, -30, -40, -50
+};
+
+static constexpr int BISHOP_TABLE[SQUARE_COUNT] = {
+	-20, -10, -10, -10, -10, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,  10,  10,   5,   0, -10,
+	-10,   5,   5,  10,  10,   5,   5, -10,
+	-10,   0,  10,  10,  10,  10,   0, -10,
+	-10,  10,  10,  10,  10,  10,  10, -10,
+	-10,   5,   0,   0,   0,   0,   5, -10,
+	-20, -10, -10, -10, -10, -10, -10, -20
+};
+
+static constexpr int ROOK_TABLE[SQUARE_COUNT] = {
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  5,  10,  10,  10,  10,  10,  10,   5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	  0,   0,   0,   5,   5,   0,   0,   0
+};
+
+static constexpr int QUEEN_TABLE[SQUARE_COUNT] = {
+	-20, -10, -10,  -5,  -5, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,   5,   5,   5,   0, -10,
+	 -5,   0,   5,   5,   5,   5,   0,  -5,
+	  0,   0,   5,   5,   5,   5,   0,  -5,
+	-10,   5,   5,   5,   5,   5,   0, -10,
+	-10,   0,   5,   0,   0,   0,   0, -10,
+	-20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+static constexpr int KING_MIDDLEGAME[SQUARE_COUNT] = {
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-20, -30, -30, -40, -40, -30, -30, -20,
+	-10, -20, -20, -20, -20, -20, -20, -10,
+	 20,  20,   0,   0,   0,   0,  20,  20,
+	 20,  30,  10,   0,   0,  10,  30,  20
+};
+
+static constexpr int KING_ENDGAME[SQUARE_COUNT] = {
+	-50, -40, -30, -20, -20, -30, -40, -50,
+	-30, -20, -10,   0,   0, -10, -20, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -30,   0,   0,   0,   0, -30, -30,
+	-50, -30, -30, -30, -30, -30, -30, -50
+};
+
+static constexpr const int* MIDDLEGAME_TABLES[] = { PAWN_MIDDLEGAME, KNIGHT_TABLE, BISHOP_TABLE, ROOK_TABLE, QUEEN_TABLE, KING_MIDDLEGAME };
+static constexpr const int* ENDGAME_TABLES[] = { PAWN_ENDGAME, KNIGHT_TABLE, BISHOP_TABLE, ROOK_TABLE, QUEEN_TABLE, KING_ENDGAME };
+
+void initPieceSquareScores() {
+	for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+		// Both sides always have a king, so its material would only cancel out
+		int material = type == static_cast<int>(PieceType::KING) ? 0 : getMaterialValue(static_cast<PieceType>(type)) * PAWN_SCORE;
+		for (int square = 0; square < SQUARE_COUNT; square++) {
+			Score white, black;
+			white.middlegame = material + MIDDLEGAME_TABLES[type][square];
+			white.endgame = material + ENDGAME_TABLES[type][square];
+			int mirrored = square ^ (SQUARE_COUNT - BOARD_WIDTH);
+			black.middlegame = -(material + MIDDLEGAME_TABLES[type][mirrored]);
+			black.endgame = -(material + ENDGAME_TABLES[type][mirrored]);
+			PIECE_SQUARE_SCORES[static_cast<int>(PieceColor::WHITE)][type][square] = white;
+			PIECE_SQUARE_SCORES[static_cast<int>(PieceColor::BLACK)][type][square] = black;
+		}
+	}
+}
+
+struct PieceSquareScoresInitializer {
+	PieceSquareScoresInitializer() {
+		initPieceSquareScores();
+	}
+} pieceSquareScoresInitializer;
+
+int evaluate(const Game& game, PawnTable& pawns) {
+	PROFILE_SCOPE(EVALUATION);
+	const PawnEntry& entry = pawns.probe(game);
+	Score score = game.getScore();
+	score += entry.score;
+	// Pawn shelter only counts while the king is still at home
+	for (PieceColor color : { PieceColor::WHITE, PieceColor::BLACK }) {
+		Bitboard king = game.getPieces(color, PieceType::KING);
+		bool white = color == PieceColor::WHITE;
+		if (king & (white ? getRowMask(BOARD_HEIGHT - 1) | getRowMask(BOARD_HEIGHT - 2) : getRowMask(0) | getRowMask(1))) {
+			int shelter = entry.shelter[static_cast<int>(color)][getLowestSquare(king) % BOARD_WIDTH];
+			score.middlegame += white ? shelter : -shelter;
+		}
+	}
+	int phase = std::min(game.getPhase(), MAX_PHASE);
+	int value = (score.middlegame * phase + score.endgame * (MAX_PHASE - phase)) / MAX_PHASE;
+	return game.getCurrentTurn() == PieceColor::WHITE ? value : -value;
+}
\ No newline at end of file
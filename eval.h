@@ -0,0 +1,45 @@
+#pragma once
+
+#include "bitboard.h"
+#include "piece.h"
+
+class Game;
+class PawnTable;
+
+// A pair of scores, one for the middlegame and one for the endgame, blended by
+// how much material is left on the board. Positive values favor white.
+struct Score {
+	int middlegame = 0;
+	int endgame = 0;
+	Score& operator+=(Score score) {
+		middlegame += score.middlegame;
+		endgame += score.endgame;
+		return *this;
+	}
+	Score& operator-=(Score score) {
+		middlegame -= score.middlegame;
+		endgame -= score.endgame;
+		return *this;
+	}
+};
+
+static constexpr int MAX_PHASE = 24;
+
+// Material plus the piece-square bonus for every piece on every square, with
+// black's entries already negated
+extern Score PIECE_SQUARE_SCORES[COLOR_COUNT][PIECE_TYPE_COUNT][SQUARE_COUNT];
+
+inline Score getPieceSquareScore(Piece piece, int square) {
+	return PIECE_SQUARE_SCORES[static_cast<int>(piece.getColor())][static_cast<int>(piece.getType())][square];
+}
+
+// How much a piece counts towards the game still being in the middlegame
+inline int getPhaseWeight(PieceType type) {
+	static constexpr int weights[] = { 0, 1, 1, 2, 4, 0, 0 };
+	return weights[static_cast<int>(type)];
+}
+
+// The static evaluation in centipawns from the side to move's point of view.
+// Game keeps the material and piece-square sums up to date and the pawn table
+// almost always knows the pawn structure, so this is close to O(1).
+int evaluate(const Game& game, PawnTable& pawns);
\ No newline at end of file
@@ -1,7 +1,7 @@
 ﻿#include <algorithm>
 #include <iterator>
 #include <vector>
-#include <map>
+#include <type_traits>
 
 #include "constants.h"
 #include "game.h"
@@ -9,36 +9,293 @@
 #include "piece.h"
 #include "ai.h"
 #include "menu.h"
+#include "movegen.h"
+#include "profile.h"
+#include "zobrist.h"
 
-Game::Game(const Game& game) {
-	currentTurn = game.currentTurn;
-	mode = game.mode;
-	selectedPiece = game.selectedPiece;
-	selectedTarget = game.selectedTarget;
-	for (int y = 0; y < BOARD_WIDTH; y++) {
-		for (int x = 0; x < BOARD_HEIGHT; x++) {
-			pieces[y][x] = game.pieces[y][x];
-		}
+static_assert(std::is_trivially_copyable<Game>::value, "Game must stay cheap to copy");
+
+static_assert(sizeof(Piece) == 1, "Piece must fit in a byte");
+
+Piece Game::getPiece(Point location) {
+	int square = getSquare(location);
+	Piece piece = mailbox[square];
+	piece.setFirstMove((unmoved & getSquareMask(square)) != 0);
+	return piece;
+}
+
+// The mailbox never stores first move flags, those live in the unmoved board
+void Game::setSquare(int square, Piece piece) {
+	Bitboard mask = getSquareMask(square);
+	int color = static_cast<int>(piece.getColor());
+	pieceBoards[color][static_cast<int>(piece.getType())] |= mask;
+	colorBoards[color] |= mask;
+	occupied |= mask;
+	piece.setFirstMove(false);
+	mailbox[square] = piece;
+	key ^= getPieceKey(piece, square);
+	if (piece.getType() == PieceType::PAWN) {
+		pawnKey ^= getPieceKey(piece, square);
+	}
+	score += getPieceSquareScore(piece, square);
+	phase += getPhaseWeight(piece.getType());
+}
+
+void Game::clearSquare(int square) {
+	Piece piece = mailbox[square];
+	Bitboard mask = getSquareMask(square);
+	int color = static_cast<int>(piece.getColor());
+	pieceBoards[color][static_cast<int>(piece.getType())] &= ~mask;
+	colorBoards[color] &= ~mask;
+	occupied &= ~mask;
+	mailbox[square] = Piece();
+	key ^= getPieceKey(piece, square);
+	if (piece.getType() == PieceType::PAWN) {
+		pawnKey ^= getPieceKey(piece, square);
+	}
+	score -= getPieceSquareScore(piece, square);
+	phase -= getPhaseWeight(piece.getType());
+}
+
+void Game::moveSquare(int from, int to) {
+	Piece piece = mailbox[from];
+	Bitboard mask = getSquareMask(from) | getSquareMask(to);
+	int color = static_cast<int>(piece.getColor());
+	pieceBoards[color][static_cast<int>(piece.getType())] ^= mask;
+	colorBoards[color] ^= mask;
+	occupied ^= mask;
+	mailbox[from] = Piece();
+	mailbox[to] = piece;
+	key ^= getPieceKey(piece, from) ^ getPieceKey(piece, to);
+	if (piece.getType() == PieceType::PAWN) {
+		pawnKey ^= getPieceKey(piece, from) ^ getPieceKey(piece, to);
+	}
+	score -= getPieceSquareScore(piece, from);
+	score += getPieceSquareScore(piece, to);
+}
+
+void Game::putPiece(int square, Piece piece) {
+	removePiece(square);
+	setSquare(square, piece);
+	if (piece.isFirstMove()) {
+		unmoved |= getSquareMask(square);
+	}
+}
+
+void Game::removePiece(int square) {
+	if (!mailbox[square].isEmpty()) {
+		clearSquare(square);
+		unmoved &= ~getSquareMask(square);
+	}
+}
+
+// The en passant square only counts towards the key when a pawn can actually
+// capture there, otherwise transpositions after a double push would never match
+uint64_t Game::getEnPassantKey() {
+	if (enPassantSquare == NO_SQUARE ||
+		!(getPawnAttacks(static_cast<int>(getOpposite(currentTurn)), enPassantSquare) & getPieces(currentTurn, PieceType::PAWN))) {
+		return 0;
+	}
+	return ZOBRIST.enPassant[enPassantSquare % BOARD_WIDTH];
+}
+
+uint64_t Game::computeKey() {
+	uint64_t result = ZOBRIST.castling[castlingRights] ^ getEnPassantKey();
+	if (currentTurn == PieceColor::BLACK) {
+		result ^= ZOBRIST.side;
+	}
+	Bitboard pieces = occupied;
+	while (pieces) {
+		int square = popLowestSquare(pieces);
+		result ^= getPieceKey(mailbox[square], square);
+	}
+	return result;
+}
+
+void Game::setCurrentTurn(PieceColor color) {
+	if (color != currentTurn) {
+		key ^= getEnPassantKey();
+		currentTurn = color;
+		key ^= getEnPassantKey() ^ ZOBRIST.side;
 	}
 }
 
 void Game::reset() {
-	std::fill(pieces[0], pieces[0] + BOARD_WIDTH * BOARD_HEIGHT, Piece(PieceType::EMPTY, PieceColor::WHITE));
+	std::fill(pieceBoards[0], pieceBoards[0] + COLOR_COUNT * PIECE_TYPE_COUNT, 0);
+	std::fill(colorBoards, colorBoards + COLOR_COUNT, 0);
+	std::fill(mailbox, mailbox + SQUARE_COUNT, Piece());
+	occupied = 0;
+	unmoved = 0;
+	pawnKey = 0;
+	score = Score();
+	phase = 0;
+	enPassantSquare = NO_SQUARE;
+	castlingRights = ALL_CASTLING;
+	halfmoveClock = 0;
+	fullmoveNumber = 1;
+	historyLength = 0;
+	legalMovesValid = false;
+	currentTurn = PieceColor::WHITE;
 	for (int x = 0; x < BOARD_WIDTH; x++) {
-		pieces[1][x] = Piece(PieceType::PAWN, PieceColor::BLACK);
-		pieces[6][x] = Piece(PieceType::PAWN, PieceColor::WHITE);
+		putPiece(getSquare(x, 1), Piece(PieceType::PAWN, PieceColor::BLACK));
+		putPiece(getSquare(x, 6), Piece(PieceType::PAWN, PieceColor::WHITE));
 	}
 	for (int row : {0, 7}) {
 		PieceColor color = row == 0 ? PieceColor::BLACK : PieceColor::WHITE;
-		pieces[row][0] = Piece(PieceType::ROOK, color);
-		pieces[row][7] = Piece(PieceType::ROOK, color);
-		pieces[row][1] = Piece(PieceType::KNIGHT, color);
-		pieces[row][6] = Piece(PieceType::KNIGHT, color);
-		pieces[row][2] = Piece(PieceType::BISHOP, color);
-		pieces[row][5] = Piece(PieceType::BISHOP, color);
-		pieces[row][3] = Piece(PieceType::QUEEN, color);
-		pieces[row][4] = Piece(PieceType::KING, color);
+		putPiece(getSquare(0, row), Piece(PieceType::ROOK, color));
+		putPiece(getSquare(7, row), Piece(PieceType::ROOK, color));
+		putPiece(getSquare(1, row), Piece(PieceType::KNIGHT, color));
+		putPiece(getSquare(6, row), Piece(PieceType::KNIGHT, color));
+		putPiece(getSquare(2, row), Piece(PieceType::BISHOP, color));
+		putPiece(getSquare(5, row), Piece(PieceType::BISHOP, color));
+		putPiece(getSquare(3, row), Piece(PieceType::QUEEN, color));
+		putPiece(getSquare(4, row), Piece(PieceType::KING, color));
+	}
+	key = computeKey();
+}
+
+bool Game::fromFEN(const std::string& fen) {
+	return fromFEN(fen.c_str());
+}
+
+// Reads digits and moves past them, false when there are none
+bool parseNumber(const char*& text, int& value) {
+	if (*text < '0' || *text > '9') {
+		return false;
+	}
+	for (value = 0; *text >= '0' && *text <= '9' && value < 1000000; text++) {
+		value = value * 10 + (*text - '0');
+	}
+	return true;
+}
+
+// Parses straight out of the text into a copy, committed only once the whole
+// record is read, so a bad FEN leaves the game untouched. The two clocks may
+// be missing, as they are in EPD records.
+bool Game::fromFEN(const char* fen) {
+	Game position;
+	const char* c = fen;
+	int x = 0, y = 0;
+	for (; *c != '\0' && *c != ' '; c++) {
+		if (*c == '/') {
+			if (x != BOARD_WIDTH || ++y >= BOARD_HEIGHT) {
+				return false;
+			}
+			x = 0;
+		}
+		else if (*c >= '1' && *c <= '8') {
+			x += *c - '0';
+		}
+		else {
+			PieceType type = getPieceType(*c);
+			if (type == PieceType::EMPTY || x >= BOARD_WIDTH) {
+				return false;
+			}
+			position.setSquare(getSquare(x, y), Piece(type, *c >= 'a' ? PieceColor::BLACK : PieceColor::WHITE));
+			x++;
+		}
+	}
+	if (x != BOARD_WIDTH || y != BOARD_HEIGHT - 1 || *c != ' ' || (c[1] != 'w' && c[1] != 'b')) {
+		return false;
+	}
+	// Everything else assumes exactly one king a side
+	if (popCount(position.getPieces(PieceColor::WHITE, PieceType::KING)) != 1 || popCount(position.getPieces(PieceColor::BLACK, PieceType::KING)) != 1) {
+		return false;
+	}
+	position.currentTurn = c[1] == 'w' ? PieceColor::WHITE : PieceColor::BLACK;
+	c += 2;
+	position.castlingRights = 0;
+	if (*c == ' ') {
+		for (c++; *c != '\0' && *c != ' '; c++) {
+			switch (*c) {
+			case 'K': position.castlingRights |= WHITE_KING_SIDE; break;
+			case 'Q': position.castlingRights |= WHITE_QUEEN_SIDE; break;
+			case 'k': position.castlingRights |= BLACK_KING_SIDE; break;
+			case 'q': position.castlingRights |= BLACK_QUEEN_SIDE; break;
+			case '-': break;
+			default: return false;
+			}
+		}
+	}
+	position.enPassantSquare = NO_SQUARE;
+	if (*c == ' ' && *++c != '-') {
+		int file = c[0] - 'a', rank = c[1] - '1';
+		if (file < 0 || file >= BOARD_WIDTH || rank < 0 || rank >= BOARD_HEIGHT) {
+			return false;
+		}
+		// Only kept when a pawn of the side that just moved really passed over
+		// it, since the move generator trusts the square blindly
+		int square = getSquare(file, BOARD_HEIGHT - 1 - rank);
+		PieceColor them = getOpposite(position.currentTurn);
+		int behind = position.currentTurn == PieceColor::WHITE ? square + BOARD_WIDTH : square - BOARD_WIDTH;
+		int origin = position.currentTurn == PieceColor::WHITE ? square - BOARD_WIDTH : square + BOARD_WIDTH;
+		if (rank == (position.currentTurn == PieceColor::WHITE ? 5 : 2) && !(position.getOccupied() & (getSquareMask(square) | getSquareMask(origin))) &&
+			(position.getPieces(them, PieceType::PAWN) & getSquareMask(behind))) {
+			position.enPassantSquare = square;
+		}
+		c++;
+	}
+	if (*c != '\0') {
+		c++;
+	}
+	position.halfmoveClock = 0;
+	position.fullmoveNumber = 1;
+	if (*c == ' ' && parseNumber(++c, position.halfmoveClock) && *c == ' ' && parseNumber(++c, position.fullmoveNumber)) {
+		position.fullmoveNumber = std::max(1, position.fullmoveNumber);
+	}
+	position.unmoved = (position.getPieces(PieceColor::WHITE, PieceType::PAWN) & getRowMask(BOARD_HEIGHT - 2)) |
+		(position.getPieces(PieceColor::BLACK, PieceType::PAWN) & getRowMask(1));
+	static constexpr int castlingSquares[][3] = {
+		{ WHITE_KING_SIDE, getSquare(4, 7), getSquare(7, 7) }, { WHITE_QUEEN_SIDE, getSquare(4, 7), getSquare(0, 7) },
+		{ BLACK_KING_SIDE, getSquare(4, 0), getSquare(7, 0) }, { BLACK_QUEEN_SIDE, getSquare(4, 0), getSquare(0, 0) }
+	};
+	for (const int* castle : castlingSquares) {
+		if (position.castlingRights & castle[0]) {
+			position.unmoved |= getSquareMask(castle[1]) | getSquareMask(castle[2]);
+		}
+	}
+	position.key = position.computeKey();
+	*this = position;
+	return true;
+}
+
+std::string Game::toFEN() const {
+	std::string fen;
+	fen.reserve(96);
+	for (int y = 0; y < BOARD_HEIGHT; y++) {
+		int empty = 0;
+		for (int x = 0; x < BOARD_WIDTH; x++) {
+			Piece piece = mailbox[getSquare(x, y)];
+			if (piece.isEmpty()) {
+				empty++;
+				continue;
+			}
+			if (empty > 0) {
+				fen += static_cast<char>('0' + empty);
+				empty = 0;
+			}
+			char display = getDisplayCharacter(piece.getType())[0];
+			fen += piece.getColor() == PieceColor::BLACK ? static_cast<char>(display - 'A' + 'a') : display;
+		}
+		if (empty > 0) {
+			fen += static_cast<char>('0' + empty);
+		}
+		fen += y + 1 < BOARD_HEIGHT ? '/' : ' ';
+	}
+	fen += currentTurn == PieceColor::WHITE ? "w " : "b ";
+	if (castlingRights == 0) {
+		fen += '-';
+	}
+	static constexpr char castlingCharacters[] = { 'K', 'Q', 'k', 'q' };
+	for (int i = 0; i < 4; i++) {
+		if (castlingRights & (1 << i)) {
+			fen += castlingCharacters[i];
+		}
 	}
+	fen += ' ';
+	fen += enPassantSquare == NO_SQUARE ? "-" : getSquareName(enPassantSquare);
+	fen += ' ' + std::to_string(halfmoveClock) + ' ' + std::to_string(fullmoveNumber);
+	return fen;
 }
 
 void Game::startGame(bool ai) {
@@ -77,6 +334,9 @@ void Game::startGame(bool ai) {
 		if (ai) {
 			draw("It's the AI's turn. Press (ENTER) for the AI to make its move.");
 			getConsole().waitForEnter();
+			if (getConsole().isClosed()) {
+				break;
+			}
 			aiMakeMove(*this);
 		}
 		else {
@@ -96,7 +356,7 @@ void Game::startGame(bool ai) {
 			}
 			moveToTarget();
 			checkPawnUpgrade(false);
-			setCurrentTurn(PieceColor::BLACK);
+			setCurrentTurn(PieceColor::WHITE);
 			state = getState();
 			if (state != GameState::PLAY) {
 				break;
@@ -105,6 +365,7 @@ void Game::startGame(bool ai) {
 		checkPawnUpgrade(ai);
 	}
 endGame:
+	stopPondering();
 	std::string message;
 	switch (state) {
 	case GameState::BLACK_WIN:
@@ -127,174 +388,74 @@ endGame:
 	getConsole().waitForEnter();
 }
 
-void Game::draw(std::string help) {
-	std::vector<std::string> gameStatus;
-	std::map<PieceType, int> remainingWhite;
-	std::map<PieceType, int> remainingBlack;
-	auto insert = [](std::map<PieceType, int>& map, PieceType type) {
-		if (!map.count(type)) {
-			map[type] = 1;
-			return;
-		}
-		map[type] += 1;
-	};
-	for (int y = 0; y < BOARD_HEIGHT; y++) {
-		for (int x = 0; x < BOARD_WIDTH; x++) {
-			if (hasPiece(Point(x, y))) {
-				Piece piece = getPiece(Point(x, y));
-				insert(piece.getColor() == PieceColor::WHITE ? remainingWhite : remainingBlack, piece.getType());
-			}
-		}
+// Screen positions of the board's top left corner and of the material counts
+static constexpr int BOARD_LEFT = 1, BOARD_TOP = 1, STATUS_LEFT = 36;
+
+void drawBoardRule(Screen& screen, int y, const char* left, const char* line, const char* join, const char* right) {
+	int x = screen.write(BOARD_LEFT, y, left);
+	for (int column = 0; column < BOARD_WIDTH; column++) {
+		x = screen.write(x, y, line);
+		x = screen.write(x, y, column < BOARD_WIDTH - 1 ? join : right);
 	}
-	for (int i = 0; i < 2; i++) {
-		PieceColor color = i == 0 ? PieceColor::BLACK : PieceColor::WHITE;
-		std::map<PieceType, int> remaining = color == PieceColor::WHITE ? remainingWhite : remainingBlack;
-		gameStatus.push_back("");
-		switch (color) {
-		case PieceColor::WHITE: gameStatus.push_back("Cyan"); break;
-		case PieceColor::BLACK: gameStatus.push_back("Yellow"); break;
-		}
+}
+
+void Game::draw(std::string help) {
+	Screen& screen = getConsole().getScreen();
+	screen.clear();
+	int row = BOARD_TOP;
+	for (PieceColor color : { PieceColor::BLACK, PieceColor::WHITE }) {
+		const char* format = color == PieceColor::WHITE ? BRIGHT_BLUE : BRIGHT_YELLOW;
+		row++;
+		screen.write(STATUS_LEFT, row++, color == PieceColor::WHITE ? "Cyan" : "Yellow");
 		int material = 0;
 		for (PieceType type : {PieceType::QUEEN, PieceType::ROOK, PieceType::BISHOP, PieceType::KNIGHT, PieceType::PAWN}) {
-			std::string format = color == PieceColor::WHITE ? BRIGHT_BLUE : BRIGHT_YELLOW;
-			int count = remaining.count(type) == 0 ? 0 : remaining[type];
+			int count = popCount(getPieces(color, type));
 			material += getMaterialValue(type) * count;
-			gameStatus.push_back(type.getName() + " (" + format + type.getDisplayCharacter() + RESET + "): " + std::to_string(count));
-		}
-		gameStatus.push_back("Total Material: " + std::to_string(material));
-	}
-	std::vector<Point> validMoves = getPiece(selectedPiece).getValidMoves(*this, selectedPiece);
-	std::string output = "\n ";
-	output += BOARD_CORNER_TOP_LEFT;
-	for (int x = 0; x < BOARD_WIDTH; x++) {
-		output += BOARD_EDGE_HORIZONTAL;
-		if (x < BOARD_WIDTH - 1) {
-			output += BOARD_EDGE_HORIZONTAL_TOP;
+			int x = screen.write(STATUS_LEFT, row, getName(type));
+			x = screen.write(x, row, " (");
+			x = screen.write(x, row, getDisplayCharacter(type), format);
+			screen.write(x, row++, "): " + std::to_string(count));
 		}
+		screen.write(STATUS_LEFT, row++, "Total Material: " + std::to_string(material));
 	}
-	output += BOARD_CORNER_TOP_RIGHT;
-	int infoIndex = 0;
-	if (infoIndex < static_cast<int>(gameStatus.size())) {
-		output += "  ";
-		output += gameStatus.at(infoIndex);
-		infoIndex++;
+	bool selecting = mode == BoardMode::SELECT_PIECE || mode == BoardMode::SELECT_TARGET;
+	Bitboard targets = 0;
+	if (selecting) {
+		targets = getLegalTargets(getSquare(selectedPiece));
 	}
-	output += "\n ";
+	drawBoardRule(screen, BOARD_TOP, BOARD_CORNER_TOP_LEFT, BOARD_EDGE_HORIZONTAL, BOARD_EDGE_HORIZONTAL_TOP, BOARD_CORNER_TOP_RIGHT);
 	for (int y = 0; y < BOARD_HEIGHT; y++) {
-		output += BOARD_EDGE_VERTICAL;
+		row = BOARD_TOP + 1 + 2 * y;
+		screen.write(BOARD_LEFT, row, BOARD_EDGE_VERTICAL);
 		for (int x = 0; x < BOARD_WIDTH; x++) {
+			int left = BOARD_LEFT + 1 + 4 * x;
+			bool possibleTarget = (targets & getSquareMask(getSquare(x, y))) != 0;
+			bool target = mode == BoardMode::SELECT_TARGET && selectedTarget.x == x && selectedTarget.y == y;
+			bool lastMove = !firstMove && ((lastSelected.x == x && lastSelected.y == y) || (lastTarget.x == x && lastTarget.y == y));
 			if (hasPiece(Point(x, y))) {
 				Piece piece = getPiece(Point(x, y));
-				bool possibleTarget = false;
-				if (mode == BoardMode::SELECT_PIECE || mode == BoardMode::SELECT_TARGET) {
-					for (Point point : validMoves) {
-						if (x == point.x && y == point.y) {
-							possibleTarget = true;
-							break;
-						}
-					}
+				const char* foreground = piece.getColor() == PieceColor::WHITE ? BRIGHT_BLUE : BRIGHT_YELLOW;
+				if (selecting && x == selectedPiece.x && y == selectedPiece.y) {
+					foreground = mode == BoardMode::SELECT_TARGET ? BRIGHT_RED : RED;
 				}
-				output += " ";
-				if (piece.getColor() == PieceColor::WHITE) {
-					output += BRIGHT_BLUE;
-				}
-				else {
-					output += BRIGHT_YELLOW;
-				}
-				if (x == selectedPiece.x && y == selectedPiece.y) {
-					if (mode == BoardMode::SELECT_TARGET) {
-						output += BRIGHT_RED;
-					}
-					else if (mode == BoardMode::SELECT_PIECE) {
-						output += RED;
-					}
-				}
-				if (!firstMove && ((lastSelected.x == x && lastSelected.y == y) || (lastTarget.x == x && lastTarget.y == y))) {
-					output += BRIGHT_GREEN_HIGHLIGHT;
-				}
-				if (mode == BoardMode::SELECT_TARGET && selectedTarget.x == x && selectedTarget.y == y) {
-					output += BRIGHT_RED_HIGHLIHT;
-				}
-				else if (possibleTarget) {
-					output += RED_HIGHLIHT;
-				}
-				output += piece.getType().getDisplayCharacter();
-				output += RESET;
-				output += " ";
+				const char* background = target ? BRIGHT_RED_HIGHLIHT : possibleTarget ? RED_HIGHLIHT : lastMove ? BRIGHT_GREEN_HIGHLIGHT : nullptr;
+				screen.write(left + 1, row, getDisplayCharacter(piece.getType()), foreground, background);
 			}
-			else {
-				if (mode == BoardMode::SELECT_PIECE || mode == BoardMode::SELECT_TARGET) {
-					bool validMove = false;
-					for (Point point : validMoves) {
-						if (x == point.x && y == point.y) {
-							validMove = true;
-							break;
-						}
-					}
-					if (validMove) {
-						if (mode == BoardMode::SELECT_TARGET && selectedTarget.x == x && selectedTarget.y == y) {
-							output += RED;
-						}
-						output += u8" ■ ";
-						if (mode == BoardMode::SELECT_TARGET && selectedTarget.x == x && selectedTarget.y == y) {
-							output += RESET;
-						}
-					}
-					else {
-						output += "   ";
-					}
-				}
-				else {
-					output += " ";
-					if (!firstMove && ((lastSelected.x == x && lastSelected.y == y) || (lastTarget.x == x && lastTarget.y == y))) {
-						output += BRIGHT_GREEN_HIGHLIGHT;
-					}
-					output += " ";
-					output += RESET;
-					output += " ";
-				}
+			else if (possibleTarget) {
+				screen.write(left, row, u8" ■ ", target ? RED : nullptr);
 			}
-			if (x < BOARD_WIDTH - 1) {
-				output += BOARD_INTERNAL_VERTICAL;
+			else if (!selecting && lastMove) {
+				screen.write(left + 1, row, " ", nullptr, BRIGHT_GREEN_HIGHLIGHT);
 			}
+			screen.write(left + 3, row, x < BOARD_WIDTH - 1 ? BOARD_INTERNAL_VERTICAL : BOARD_EDGE_VERTICAL);
 		}
-		output += BOARD_EDGE_VERTICAL;
-		if (infoIndex < static_cast<int>(gameStatus.size())) {
-			output += "  ";
-			output += gameStatus.at(infoIndex);
-			infoIndex++;
-		}
-		output += "\n ";
 		if (y < BOARD_HEIGHT - 1) {
-			output += BOARD_EDGE_VERTICAL_LEFT;
-			for (int x = 0; x < BOARD_WIDTH; x++) {
-				output += BOARD_INTERNAL_HORIZONTAL;
-				if (x < BOARD_WIDTH - 1) {
-					output += BOARD_INTERNAL_INTERSECT;
-				}
-			}
-			output += BOARD_EDGE_VERTICAL_RIGHT;
-			if (infoIndex < static_cast<int>(gameStatus.size())) {
-				output += "  ";
-				output += gameStatus.at(infoIndex);
-				infoIndex++;
-			}
-			output += "\n ";
-		}
-	}
-	output += BOARD_CORNER_BOTTOM_LEFT;
-	for (int x = 0; x < BOARD_WIDTH; x++) {
-		output += BOARD_EDGE_HORIZONTAL;
-		if (x < BOARD_WIDTH - 1) {
-			output += BOARD_EDGE_HORIZONTAL_BOTTOM;
+			drawBoardRule(screen, row + 1, BOARD_EDGE_VERTICAL_LEFT, BOARD_INTERNAL_HORIZONTAL, BOARD_INTERNAL_INTERSECT, BOARD_EDGE_VERTICAL_RIGHT);
 		}
 	}
-	output += BOARD_CORNER_BOTTOM_RIGHT;
-	output += "\n\n";
-	output += help;
-	Console& out = getConsole();
-	out.clear();
-	out.println(output);
+	drawBoardRule(screen, row + 1, BOARD_CORNER_BOTTOM_LEFT, BOARD_EDGE_HORIZONTAL, BOARD_EDGE_HORIZONTAL_BOTTOM, BOARD_CORNER_BOTTOM_RIGHT);
+	screen.writeText(0, row + 3, help);
+	getConsole().refresh();
 }
 
 bool checkOffsets(Point location, Point target, int x, int y) {
@@ -324,7 +485,7 @@ Point Game::findNearestPiece(Point location, PieceColor color, int xOffset, int
 				break;
 			}
 			for (int x = 0; x < BOARD_HEIGHT; x++) {
-				if (hasPiece(Point(x, y)) && pieces[y][x].getColor() == color) {
+				if (hasPiece(Point(x, y)) && getPiece(Point(x, y)).getColor() == color) {
 					result = Point(x, y);
 					found = true;
 					break;
@@ -339,7 +500,7 @@ Point Game::findNearestPiece(Point location, PieceColor color, int xOffset, int
 		for (int x = 0; x < BOARD_HEIGHT; x++) {
 			Point point(x, y);
 			if (hasPiece(point)) {
-				Piece piece = pieces[y][x];
+				Piece piece = getPiece(point);
 				if (piece.getColor() == color) {
 					if (!checkOffsets(location, result, xOffset, yOffset)) {
 						if (checkOffsets(location, point, xOffset, yOffset)) {
@@ -369,7 +530,7 @@ bool Game::selectPiece() {
 		int x = 0, y = 0;
 		switch (in.getDirectionalInput(true)) {
 		case DirectionalInput::ENTER:
-			if (getPiece(selectedPiece).getValidMoves(*this, selectedPiece).size() == 0) {
+			if (getLegalTargets(getSquare(selectedPiece)) == 0) {
 				break;
 			}
 			mode = BoardMode::DISPLAY;
@@ -451,71 +612,187 @@ void Game::moveToTarget() {
 	lastSelected = selectedPiece;
 	lastTarget = selectedTarget;
 	firstMove = false;
-	Piece piece = pieces[selectedPiece.y][selectedPiece.x];
-	pieces[selectedPiece.y][selectedPiece.x] = Piece();
-	if (piece.getType() == PieceType::KING && piece.isFirstMove()) {
-		if (selectedTarget.x == 6) {
-			Piece rook = pieces[selectedPiece.y][7];
-			if (rook.isFirstMove()) {
-				pieces[selectedPiece.y][7] = Piece();
-				rook.setFirstMove(false);
-				pieces[selectedPiece.y][5] = rook;
-			}
+	int from = getSquare(selectedPiece), to = getSquare(selectedTarget);
+	for (Move move : getLegalMoves()) {
+		// Promotions are listed queen first, the upgrade menu can replace it afterwards
+		if (move.getFrom() == from && move.getTo() == to) {
+			pendingUpgrade = move.isPromotion();
+			makeMove(move);
+			return;
 		}
-		else if (selectedTarget.x == 2) {
-			Piece rook = pieces[selectedPiece.y][0];
-			if (rook.isFirstMove()) {
-				pieces[selectedPiece.y][0] = Piece();
-				rook.setFirstMove(false);
-				pieces[selectedPiece.y][3] = rook;
-			}
+	}
+}
+
+// Castling rights that survive a move touching each square
+int getCastlingMask(int square) {
+	switch (square) {
+	case getSquare(0, 0): return ALL_CASTLING & ~BLACK_QUEEN_SIDE;
+	case getSquare(4, 0): return ALL_CASTLING & ~(BLACK_KING_SIDE | BLACK_QUEEN_SIDE);
+	case getSquare(7, 0): return ALL_CASTLING & ~BLACK_KING_SIDE;
+	case getSquare(0, 7): return ALL_CASTLING & ~WHITE_QUEEN_SIDE;
+	case getSquare(4, 7): return ALL_CASTLING & ~(WHITE_KING_SIDE | WHITE_QUEEN_SIDE);
+	case getSquare(7, 7): return ALL_CASTLING & ~WHITE_KING_SIDE;
+	default: return ALL_CASTLING;
+	}
+}
+
+UndoInfo Game::makeMove(Move move) {
+	PROFILE_SCOPE(MAKE_MOVE);
+	UndoInfo undo;
+	undo.key = key;
+	undo.pawnKey = pawnKey;
+	undo.unmoved = unmoved;
+	undo.captured = Piece();
+	undo.castlingRights = static_cast<uint8_t>(castlingRights);
+	undo.enPassantSquare = static_cast<int8_t>(enPassantSquare);
+	undo.halfmoveClock = static_cast<int16_t>(halfmoveClock);
+	keyHistory[historyLength++ & (KEY_HISTORY_SIZE - 1)] = key;
+	int from = move.getFrom(), to = move.getTo();
+	PieceColor color = mailbox[from].getColor();
+	halfmoveClock = move.isCapture() || mailbox[from].getType() == PieceType::PAWN ? 0 : halfmoveClock + 1;
+	fullmoveNumber += color == PieceColor::BLACK ? 1 : 0;
+	key ^= ZOBRIST.castling[castlingRights] ^ getEnPassantKey() ^ ZOBRIST.side;
+	if (move.isEnPassant()) {
+		int captured = to + (color == PieceColor::WHITE ? BOARD_WIDTH : -BOARD_WIDTH);
+		undo.captured = mailbox[captured];
+		clearSquare(captured);
+	}
+	else if (move.isCapture()) {
+		undo.captured = mailbox[to];
+		clearSquare(to);
+	}
+	moveSquare(from, to);
+	if (move.isCastle()) {
+		if (move.getFlags() == Move::KING_CASTLE) {
+			moveSquare(to + 1, to - 1);
+		}
+		else {
+			moveSquare(to - 2, to + 1);
 		}
 	}
-	piece.setFirstMove(false);
-	pieces[selectedTarget.y][selectedTarget.x] = piece;
+	if (move.isPromotion()) {
+		clearSquare(to);
+		setSquare(to, Piece(move.getPromotion(), color));
+	}
+	unmoved &= ~(getSquareMask(from) | getSquareMask(to));
+	castlingRights &= getCastlingMask(from) & getCastlingMask(to);
+	enPassantSquare = move.getFlags() == Move::DOUBLE_PAWN_PUSH ? (from + to) / 2 : NO_SQUARE;
+	currentTurn = getOpposite(currentTurn);
+	key ^= ZOBRIST.castling[castlingRights] ^ getEnPassantKey();
+	return undo;
 }
 
-bool Game::isInCheck(PieceColor color) {
-	Point king(0, 0);
-	bool foundKing = false;
-	for (int y = 0; y < BOARD_WIDTH; y++) {
-		if (foundKing) {
-			break;
+void Game::unmakeMove(Move move, const UndoInfo& undo) {
+	PROFILE_SCOPE(UNMAKE_MOVE);
+	int from = move.getFrom(), to = move.getTo();
+	currentTurn = getOpposite(currentTurn);
+	if (move.isPromotion()) {
+		PieceColor color = mailbox[to].getColor();
+		clearSquare(to);
+		setSquare(to, Piece(PieceType::PAWN, color));
+	}
+	moveSquare(to, from);
+	if (move.isCastle()) {
+		if (move.getFlags() == Move::KING_CASTLE) {
+			moveSquare(to - 1, to + 1);
 		}
-		for (int x = 0; x < BOARD_HEIGHT; x++) {
-			Point point(x, y);
-			if (hasPiece(point)) {
-				Piece piece = getPiece(point);
-				if (piece.getColor() == color && piece.getType() == PieceType::KING) {
-					king = point;
-					foundKing = true;
-					break;
-				}
-			}
+		else {
+			moveSquare(to + 1, to - 2);
 		}
 	}
-	if (!foundKing) {
+	if (!undo.captured.isEmpty()) {
+		int captured = to;
+		if (move.isEnPassant()) {
+			captured += mailbox[from].getColor() == PieceColor::WHITE ? BOARD_WIDTH : -BOARD_WIDTH;
+		}
+		setSquare(captured, undo.captured);
+	}
+	key = undo.key;
+	pawnKey = undo.pawnKey;
+	unmoved = undo.unmoved;
+	castlingRights = undo.castlingRights;
+	enPassantSquare = undo.enPassantSquare;
+	halfmoveClock = undo.halfmoveClock;
+	fullmoveNumber -= currentTurn == PieceColor::BLACK ? 1 : 0;
+	historyLength--;
+}
+
+bool Game::isSquareAttacked(int square, PieceColor byColor) {
+	Bitboard queens = getPieces(byColor, PieceType::QUEEN);
+	return (getPawnAttacks(static_cast<int>(getOpposite(byColor)), square) & getPieces(byColor, PieceType::PAWN)) ||
+		(getKnightAttacks(square) & getPieces(byColor, PieceType::KNIGHT)) ||
+		(getKingAttacks(square) & getPieces(byColor, PieceType::KING)) ||
+		(getBishopAttacks(square, occupied) & (getPieces(byColor, PieceType::BISHOP) | queens)) ||
+		(getRookAttacks(square, occupied) & (getPieces(byColor, PieceType::ROOK) | queens));
+}
+
+// Pieces of both colors attacking the square, with sliders blocked only by the
+// given occupancy so captures can be played out without touching the board
+Bitboard Game::getAttackers(int square, Bitboard occupied) const {
+	Bitboard diagonal = getPieces(PieceColor::WHITE, PieceType::BISHOP) | getPieces(PieceColor::BLACK, PieceType::BISHOP) |
+		getPieces(PieceColor::WHITE, PieceType::QUEEN) | getPieces(PieceColor::BLACK, PieceType::QUEEN);
+	Bitboard straight = getPieces(PieceColor::WHITE, PieceType::ROOK) | getPieces(PieceColor::BLACK, PieceType::ROOK) |
+		getPieces(PieceColor::WHITE, PieceType::QUEEN) | getPieces(PieceColor::BLACK, PieceType::QUEEN);
+	return (getPawnAttacks(static_cast<int>(PieceColor::BLACK), square) & getPieces(PieceColor::WHITE, PieceType::PAWN)) |
+		(getPawnAttacks(static_cast<int>(PieceColor::WHITE), square) & getPieces(PieceColor::BLACK, PieceType::PAWN)) |
+		(getKnightAttacks(square) & (getPieces(PieceColor::WHITE, PieceType::KNIGHT) | getPieces(PieceColor::BLACK, PieceType::KNIGHT))) |
+		(getKingAttacks(square) & (getPieces(PieceColor::WHITE, PieceType::KING) | getPieces(PieceColor::BLACK, PieceType::KING))) |
+		(getBishopAttacks(square, occupied) & diagonal) | (getRookAttacks(square, occupied) & straight);
+}
+
+bool Game::isInCheck(PieceColor color) {
+	Bitboard king = getPieces(color, PieceType::KING);
+	if (!king) {
 		return true;
 	}
+	return isSquareAttacked(getLowestSquare(king), getOpposite(color));
+}
 
-	for (int y = 0; y < BOARD_WIDTH; y++) {
-		for (int x = 0; x < BOARD_HEIGHT; x++) {
-			Point point(x, y);
-			if (hasPiece(point)) {
-				Piece piece = getPiece(point);
-				if (piece.getColor() != color) {
-					for (Point move : piece.getMoves(*this, point)) {
-						if (move == king) {
-							return true;
-						}
-					}
-				}
-			}
+// Only positions since the last capture or pawn move can come back, and with
+// the same side to move, so only every other earlier position is compared
+bool Game::isRepetition(int times) const {
+	int distance = std::min(std::min(halfmoveClock, historyLength), KEY_HISTORY_SIZE);
+	int found = 0;
+	for (int plies = 4; plies <= distance; plies += 2) {
+		if (keyHistory[(historyLength - plies) & (KEY_HISTORY_SIZE - 1)] == key && ++found >= times) {
+			return true;
 		}
 	}
 	return false;
 }
 
+// Bare kings, a single minor piece, or bishops that all stand on one color
+bool Game::isInsufficientMaterial() const {
+	static constexpr Bitboard DARK_SQUARES = 0x55AA55AA55AA55AAULL;
+	Bitboard minors = 0, bishops = 0;
+	for (PieceColor color : { PieceColor::WHITE, PieceColor::BLACK }) {
+		if (getPieces(color, PieceType::PAWN) | getPieces(color, PieceType::ROOK) | getPieces(color, PieceType::QUEEN)) {
+			return false;
+		}
+		minors |= getPieces(color, PieceType::KNIGHT) | getPieces(color, PieceType::BISHOP);
+		bishops |= getPieces(color, PieceType::BISHOP);
+	}
+	return popCount(minors) <= 1 || (minors == bishops && (!(bishops & DARK_SQUARES) || !(bishops & ~DARK_SQUARES)));
+}
+
+const MoveList& Game::getLegalMoves() {
+	if (!legalMovesValid || legalMovesKey != key) {
+		legalMoves.clear();
+		generateLegalMoves(*this, currentTurn, legalMoves);
+		legalMovesKey = key;
+		legalMovesValid = true;
+	}
+	return legalMoves;
+}
+
+Bitboard Game::getLegalTargets(int square) {
+	Bitboard targets = 0;
+	for (Move move : getLegalMoves()) {
+		targets |= move.getFrom() == square ? getSquareMask(move.getTo()) : 0;
+	}
+	return targets;
+}
+
 GameState Game::getState() {
 	if (blackResigned) {
 		return GameState::BLACK_RESIGN;
@@ -523,18 +800,11 @@ GameState Game::getState() {
 	if (whiteResigned) {
 		return GameState::WHITE_RESIGN;
 	}
-	for (int y = 0; y < BOARD_WIDTH; y++) {
-		for (int x = 0; x < BOARD_HEIGHT; x++) {
-			Point point(x, y);
-			if (hasPiece(point)) {
-				Piece piece = getPiece(point);
-				if (piece.getColor() == currentTurn) {
-					if (piece.getValidMoves(*this, point).size() > 0) {
-						return GameState::PLAY;
-					}
-				}
-			}
-		}
+	// The cached list answers for free when it is current, otherwise the early
+	// exit check is cheaper than generating every move
+	bool canMove = legalMovesValid && legalMovesKey == key ? !legalMoves.empty() : hasLegalMove(*this, currentTurn);
+	if (canMove) {
+		return halfmoveClock >= 100 || isRepetition(2) || isInsufficientMaterial() ? GameState::DRAW : GameState::PLAY;
 	}
 	if (isInCheck(currentTurn)) {
 		switch (currentTurn) {
@@ -546,26 +816,29 @@ GameState Game::getState() {
 }
 
 void Game::checkPawnUpgrade(bool ai) {
-	int y = currentTurn == PieceColor::WHITE ? 0 : BOARD_HEIGHT - 1;
-	for (int x = 0; x < BOARD_WIDTH; x++) {
-		Point point(x, y);
-		if (hasPiece(point)) {
-			Piece piece = getPiece(point);
-			if (piece.getColor() == currentTurn && piece.getType() == PieceType::PAWN) {
-				PieceType upgrade = PieceType::QUEEN;
-				std::vector<std::string> options{ "Queen", "Rook", "Bishop", "Knight" };
-				std::string selection = displayMenu("You have earned a pawn upgrade! Select a replacement.", options);
-				if (selection == options.at(1)) {
-					upgrade = PieceType::ROOK;
-				}
-				else if (selection == options.at(2)) {
-					upgrade = PieceType::BISHOP;
-				}
-				else if (selection == options.at(3)) {
-					upgrade = PieceType::KNIGHT;
-				}
-				pieces[y][x] = Piece(upgrade, currentTurn);
-			}
-		}
+	if (!pendingUpgrade) {
+		return;
+	}
+	pendingUpgrade = false;
+	if (ai) {
+		return;
+	}
+	int square = getSquare(lastTarget);
+	PieceColor color = getPiece(lastTarget).getColor();
+	PieceType upgrade = PieceType::QUEEN;
+	std::vector<std::string> options{ "Queen", "Rook", "Bishop", "Knight" };
+	std::string selection = displayMenu("You have earned a pawn upgrade! Select a replacement.", options);
+	if (selection == options.at(1)) {
+		upgrade = PieceType::ROOK;
+	}
+	else if (selection == options.at(2)) {
+		upgrade = PieceType::BISHOP;
+	}
+	else if (selection == options.at(3)) {
+		upgrade = PieceType::KNIGHT;
 	}
+	removePiece(square);
+	Piece replacement(upgrade, color);
+	replacement.setFirstMove(false);
+	putPiece(square, replacement);
 }
\ No newline at end of file
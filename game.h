@@ -1,5 +1,10 @@
 #pragma once
+#include <string>
+
 #include "constants.h"
+#include "bitboard.h"
+#include "eval.h"
+#include "move.h"
 #include "piece.h"
 
 enum class BoardMode {
@@ -17,31 +22,96 @@ enum class GameState {
 	BLACK_RESIGN
 };
 
+static constexpr int WHITE_KING_SIDE = 1, WHITE_QUEEN_SIDE = 2, BLACK_KING_SIDE = 4, BLACK_QUEEN_SIDE = 8;
+static constexpr int ALL_CASTLING = WHITE_KING_SIDE | WHITE_QUEEN_SIDE | BLACK_KING_SIDE | BLACK_QUEEN_SIDE;
+
+// Everything makeMove changes that unmakeMove can't work out from the move itself
+struct UndoInfo {
+	uint64_t key, pawnKey;
+	Bitboard unmoved;
+	Piece captured;
+	uint8_t castlingRights;
+	int8_t enPassantSquare;
+	int16_t halfmoveClock;
+};
+
+static constexpr int KEY_HISTORY_SIZE = 256;
+
 class Game {
 private:
-	Piece pieces[BOARD_HEIGHT][BOARD_WIDTH];
+	Bitboard pieceBoards[COLOR_COUNT][PIECE_TYPE_COUNT] = {};
+	Bitboard colorBoards[COLOR_COUNT] = {};
+	Bitboard occupied = 0, unmoved = 0;
+	Piece mailbox[SQUARE_COUNT];
+	int enPassantSquare = NO_SQUARE, castlingRights = 0;
+	int halfmoveClock = 0, fullmoveNumber = 1;
+	// Keys of the positions before each move played, as a ring
+	uint64_t keyHistory[KEY_HISTORY_SIZE];
+	int historyLength = 0;
+	uint64_t key = 0, pawnKey = 0;
+	Score score;
+	int phase = 0;
+	// The console asks for the same position's moves over and over while the
+	// player picks a move, so they are generated once and kept by key
+	MoveList legalMoves;
+	uint64_t legalMovesKey = 0;
+	bool legalMovesValid = false;
 	BoardMode mode = BoardMode::DISPLAY;
 	Point selectedPiece = Point(0, 0), selectedTarget = Point(0, 0);
 	Point lastSelected = Point(0, 0), lastTarget = Point(0, 0);
 	PieceColor currentTurn = PieceColor::WHITE;
-	bool firstMove = true, blackResigned = false, whiteResigned = false;
+	bool firstMove = true, blackResigned = false, whiteResigned = false, pendingUpgrade = false;
+	void setSquare(int square, Piece piece);
+	void clearSquare(int square);
+	void moveSquare(int from, int to);
+	void putPiece(int square, Piece piece);
+	void removePiece(int square);
+	uint64_t getEnPassantKey();
+	uint64_t computeKey();
 public:
-	Game() {}
-	Game(const Game& game);
-	bool hasPiece(Point location) { return !(getPiece(location).getType() == PieceType::EMPTY); }
-	Piece getPiece(Point location) { return pieces[location.y][location.x]; }
-	PieceColor getCurrentTurn() { return currentTurn; }
+	bool hasPiece(Point location) { return (occupied & getSquareMask(getSquare(location))) != 0; }
+	Piece getPiece(Point location);
+	Piece getPiece(int square) const { return mailbox[square]; }
+	Bitboard getPieces(PieceColor color, PieceType type) const { return pieceBoards[static_cast<int>(color)][static_cast<int>(type)]; }
+	Bitboard getPieces(PieceColor color) const { return colorBoards[static_cast<int>(color)]; }
+	Bitboard getOccupied() const { return occupied; }
+	int getEnPassantSquare() const { return enPassantSquare; }
+	int getCastlingRights() const { return castlingRights; }
+	// Moves since the last capture or pawn move, counted in plies
+	int getHalfmoveClock() const { return halfmoveClock; }
+	int getFullmoveNumber() const { return fullmoveNumber; }
+	PieceColor getCurrentTurn() const { return currentTurn; }
+	uint64_t getKey() const { return key; }
+	// Identifies the pawns alone, for caching pawn structure evaluations
+	uint64_t getPawnKey() const { return pawnKey; }
+	Score getScore() const { return score; }
+	int getPhase() const { return phase; }
 	Point findNearestPiece(Point location, PieceColor color, int xOffset, int yOffset);
 	GameState getState();
+	// Legal moves for the side to move
+	const MoveList& getLegalMoves();
+	// Where the piece on the square can legally go, if it's the side to move's
+	Bitboard getLegalTargets(int square);
 	void setSelectedPiece(Point point) { selectedPiece = point; }
 	void setSelectedTarget(Point point) { selectedTarget = point; }
-	void setCurrentTurn(PieceColor color) { currentTurn = color; }
+	void setCurrentTurn(PieceColor color);
 	void reset();
+	bool fromFEN(const std::string& fen);
+	bool fromFEN(const char* fen);
+	std::string toFEN() const;
 	void startGame(bool ai);
 	void draw(std::string help);
 	bool selectPiece();
 	bool selectTarget();
 	void moveToTarget();
+	UndoInfo makeMove(Move move);
+	void unmakeMove(Move move, const UndoInfo& undo);
 	void checkPawnUpgrade(bool ai);
+	bool isSquareAttacked(int square, PieceColor byColor);
+	Bitboard getAttackers(int square, Bitboard occupied) const;
 	bool isInCheck(PieceColor color);
+	// Whether the current position has occurred at least this many times
+	// before, two for a threefold repetition and four for a fivefold one
+	bool isRepetition(int times) const;
+	bool isInsufficientMaterial() const;
 };
\ No newline at end of file
@@ -1,21 +1,60 @@
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
 #include "main.h"
 #include "console.h"
 #include "application.h"
+#include "ai.h"
+#include "bench.h"
+#include "bitbase.h"
+#include "profile.h"
+#include "tournament.h"
+#include "uci.h"
 
 Console* console;
 
-void start() {
+int start(int argc, char** argv) {
+	PROFILE_START();
+	std::string mode = argc > 1 ? argv[1] : "";
+	if (mode == "bench") {
+		return runScalingBenchmark(argc > 2 ? std::max(1, std::atoi(argv[2])) : 6);
+	}
+	if (mode == "bitbases") {
+		return runBitbaseGenerator(argc > 2 ? argv[2] : BITBASE_PATH);
+	}
+	// Every other mode plays games, so the endgame tables get ready meanwhile
+	if (mode == "uci") {
+		loadBitbases();
+		int result = runUci();
+		stopBitbaseGeneration();
+		return result;
+	}
+	if (mode == "tournament") {
+		TournamentOptions options;
+		if (!parseTournamentOptions(argc - 2, argv + 2, options)) {
+			return 2;
+		}
+		loadBitbases();
+		int result = runTournament(options);
+		stopBitbaseGeneration();
+		return result;
+	}
 #if defined(_WIN32)
 	console = new ConsoleWindows();
 #elif defined(__linux__) || defined(__apple__)
 	console = new ConsoleBash();
 #else
-	return;
+	return 1;
 #endif
 	console->init();
+	loadBitbases();
 	Application application;
 	application.run();
+	stopPondering();
+	stopBitbaseGeneration();
 	delete console;
+	return 0;
 }
 
 Console& getConsole() {
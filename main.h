@@ -1,3 +1,3 @@
 #pragma once
 
-void start();
\ No newline at end of file
+int start(int argc, char** argv);
\ No newline at end of file
@@ -0,0 +1,67 @@
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mappedfile.h"
+
+bool MappedFile::open(const std::string& path) {
+	close();
+#if defined(_WIN32)
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER length;
+	HANDLE view = GetFileSizeEx(handle, &length) && length.QuadPart > 0 ?
+		CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	const void* address = view ? MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!address) {
+		if (view) {
+			CloseHandle(view);
+		}
+		CloseHandle(handle);
+		return false;
+	}
+	file = handle;
+	mapping = view;
+	size = static_cast<size_t>(length.QuadPart);
+#else
+	int descriptor = ::open(path.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		return false;
+	}
+	struct stat status;
+	void* address = fstat(descriptor, &status) == 0 && status.st_size > 0 ?
+		mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0) : MAP_FAILED;
+	// The mapping keeps the file alive on its own
+	::close(descriptor);
+	if (address == MAP_FAILED) {
+		return false;
+	}
+	size = static_cast<size_t>(status.st_size);
+#endif
+	data = static_cast<const uint8_t*>(address);
+	return true;
+}
+
+void MappedFile::close() {
+	if (!data) {
+		return;
+	}
+#if defined(_WIN32)
+	UnmapViewOfFile(data);
+	CloseHandle(mapping);
+	CloseHandle(file);
+	mapping = file = nullptr;
+#else
+	munmap(const_cast<uint8_t*>(data), size);
+#endif
+	data = nullptr;
+	size = 0;
+}
\ No newline at end of file
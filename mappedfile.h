@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A whole file mapped read-only into memory. The operating system shares the
+// pages between every process that maps the same file and only reads the
+// parts that are actually touched.
+class MappedFile {
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+#if defined(_WIN32)
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile() { close(); }
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return data != nullptr; }
+	const uint8_t* getData() const { return data; }
+	size_t getSize() const { return size; }
+};
\ No newline at end of file
@@ -20,7 +20,6 @@ std::string displayMenu(std::string header, std::vector<std::string> options, st
 		}
 	}
 	while (true) {
-		out.clear();
 		if (header.size() > 0) {
 			out.bufferln();
 			out.bufferln(" " + header);
@@ -0,0 +1,20 @@
+#include "move.h"
+
+std::string getSquareName(int square) {
+	std::string name;
+	name += static_cast<char>('a' + square % BOARD_WIDTH);
+	name += static_cast<char>('0' + BOARD_HEIGHT - square / BOARD_WIDTH);
+	return name;
+}
+
+// Long algebraic notation, the format used by perft tools and the UCI protocol
+std::string Move::toString() const {
+	if (isNone()) {
+		return "0000";
+	}
+	std::string result = getSquareName(getFrom()) + getSquareName(getTo());
+	if (isPromotion()) {
+		result += static_cast<char>(getDisplayCharacter(getPromotion())[0] - 'A' + 'a');
+	}
+	return result;
+}
\ No newline at end of file
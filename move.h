@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "bitboard.h"
+#include "piece.h"
+
+// A move packed into 16 bits: the origin square, the target square and four
+// bits of flags describing what kind of move it is.
+class Move {
+private:
+	uint16_t data;
+public:
+	static constexpr int QUIET = 0, DOUBLE_PAWN_PUSH = 1, KING_CASTLE = 2, QUEEN_CASTLE = 3,
+		CAPTURE = 4, EN_PASSANT = 5, PROMOTION = 8;
+	Move() = default;
+	constexpr Move(int from, int to, int flags) : data(static_cast<uint16_t>(from | to << 6 | flags << 12)) {}
+	static constexpr Move fromData(uint16_t data) { return Move(data & 63, (data >> 6) & 63, data >> 12); }
+	static constexpr Move none() { return Move(0, 0, 0); }
+	int getFrom() const { return data & 63; }
+	int getTo() const { return (data >> 6) & 63; }
+	int getFlags() const { return data >> 12; }
+	uint16_t getData() const { return data; }
+	bool isNone() const { return data == 0; }
+	bool isCapture() const { return (getFlags() & CAPTURE) != 0; }
+	bool isPromotion() const { return (getFlags() & PROMOTION) != 0; }
+	bool isCastle() const { return getFlags() == KING_CASTLE || getFlags() == QUEEN_CASTLE; }
+	bool isEnPassant() const { return getFlags() == EN_PASSANT; }
+	PieceType getPromotion() const { return static_cast<PieceType>(static_cast<int>(PieceType::KNIGHT) + (getFlags() & 3)); }
+	std::string toString() const;
+	bool operator==(Move move) const { return data == move.data; }
+	bool operator!=(Move move) const { return data != move.data; }
+};
+
+std::string getSquareName(int square);
+
+static constexpr int MAX_MOVES = 256;
+
+// A fixed capacity list of moves meant to live on the stack, so generating
+// moves never touches the heap.
+class MoveList {
+private:
+	Move moves[MAX_MOVES];
+	int count = 0;
+public:
+	void add(Move move) { moves[count++] = move; }
+	void add(int from, int to, int flags) { moves[count++] = Move(from, to, flags); }
+	void clear() { count = 0; }
+	int size() const { return count; }
+	bool empty() const { return count == 0; }
+	Move operator[](int index) const { return moves[index]; }
+	Move* begin() { return moves; }
+	Move* end() { return moves + count; }
+	const Move* begin() const { return moves; }
+	const Move* end() const { return moves + count; }
+	bool contains(Move move) const {
+		for (int i = 0; i < count; i++) {
+			if (moves[i] == move) {
+				return true;
+			}
+		}
+		return false;
+	}
+};
\ No newline at end of file
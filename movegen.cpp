@@ -0,0 +1,288 @@
+#include "movegen.h"
+#include "game.h"
+#include "profile.h"
+
+template<PieceColor Us>
+inline Bitboard shiftForward(Bitboard board) {
+	return Us == PieceColor::WHITE ? shiftUp(board) : shiftDown(board);
+}
+
+template<PieceColor Us, GenerationType Type>
+void generatePawnMoves(Game& game, MoveList& list, Bitboard from) {
+	constexpr PieceColor Them = getOpposite(Us);
+	constexpr int Forward = Us == PieceColor::WHITE ? -BOARD_WIDTH : BOARD_WIDTH;
+	constexpr Bitboard LastRow = getRowMask(Us == PieceColor::WHITE ? 0 : BOARD_HEIGHT - 1);
+	constexpr Bitboard DoublePushRow = getRowMask(Us == PieceColor::WHITE ? BOARD_HEIGHT - 3 : 2);
+	Bitboard pawns = game.getPieces(Us, PieceType::PAWN) & from;
+	Bitboard empty = ~game.getOccupied();
+	Bitboard enemies = game.getPieces(Them);
+	Bitboard single = shiftForward<Us>(pawns) & empty;
+	if (Type != GenerationType::CAPTURES) {
+		Bitboard quiet = single & ~LastRow;
+		Bitboard doubles = shiftForward<Us>(single & DoublePushRow) & empty;
+		while (quiet) {
+			int to = popLowestSquare(quiet);
+			list.add(to - Forward, to, Move::QUIET);
+		}
+		while (doubles) {
+			int to = popLowestSquare(doubles);
+			list.add(to - 2 * Forward, to, Move::DOUBLE_PAWN_PUSH);
+		}
+	}
+	if (Type != GenerationType::QUIETS) {
+		Bitboard promotions = single & LastRow;
+		while (promotions) {
+			int to = popLowestSquare(promotions);
+			for (int piece = 3; piece >= 0; piece--) {
+				list.add(to - Forward, to, Move::PROMOTION | piece);
+			}
+		}
+		Bitboard left = shiftForward<Us>(shiftLeft(pawns)) & enemies;
+		Bitboard right = shiftForward<Us>(shiftRight(pawns)) & enemies;
+		for (int side = 0; side < 2; side++) {
+			Bitboard captures = side == 0 ? left : right;
+			int offset = side == 0 ? Forward - 1 : Forward + 1;
+			while (captures) {
+				int to = popLowestSquare(captures);
+				if (getSquareMask(to) & LastRow) {
+					for (int piece = 3; piece >= 0; piece--) {
+						list.add(to - offset, to, Move::PROMOTION | Move::CAPTURE | piece);
+					}
+				}
+				else {
+					list.add(to - offset, to, Move::CAPTURE);
+				}
+			}
+		}
+		int enPassant = game.getEnPassantSquare();
+		if (enPassant != NO_SQUARE && game.getCurrentTurn() == Us) {
+			Bitboard attackers = pawns & getPawnAttacks(static_cast<int>(Them), enPassant);
+			while (attackers) {
+				list.add(popLowestSquare(attackers), enPassant, Move::EN_PASSANT);
+			}
+		}
+	}
+}
+
+template<PieceType Type>
+inline Bitboard getPieceAttacks(int square, Bitboard occupied) {
+	switch (Type) {
+	case PieceType::KNIGHT: return getKnightAttacks(square);
+	case PieceType::BISHOP: return getBishopAttacks(square, occupied);
+	case PieceType::ROOK: return getRookAttacks(square, occupied);
+	case PieceType::QUEEN: return getQueenAttacks(square, occupied);
+	default: return getKingAttacks(square);
+	}
+}
+
+template<PieceColor Us, PieceType Type>
+void generatePieceMoves(Game& game, MoveList& list, Bitboard from, Bitboard targets) {
+	Bitboard pieces = game.getPieces(Us, Type) & from;
+	Bitboard occupied = game.getOccupied();
+	Bitboard enemies = game.getPieces(getOpposite(Us));
+	while (pieces) {
+		int square = popLowestSquare(pieces);
+		Bitboard attacks = getPieceAttacks<Type>(square, occupied) & targets;
+		Bitboard captures = attacks & enemies, quiets = attacks & ~enemies;
+		while (captures) {
+			list.add(square, popLowestSquare(captures), Move::CAPTURE);
+		}
+		while (quiets) {
+			list.add(square, popLowestSquare(quiets), Move::QUIET);
+		}
+	}
+}
+
+template<PieceColor Us>
+void generateCastling(Game& game, MoveList& list, Bitboard from) {
+	constexpr PieceColor Them = getOpposite(Us);
+	constexpr int Row = Us == PieceColor::WHITE ? BOARD_HEIGHT - 1 : 0;
+	constexpr int King = getSquare(4, Row);
+	constexpr int KingSide = Us == PieceColor::WHITE ? WHITE_KING_SIDE : BLACK_KING_SIDE;
+	constexpr int QueenSide = Us == PieceColor::WHITE ? WHITE_QUEEN_SIDE : BLACK_QUEEN_SIDE;
+	int rights = game.getCastlingRights();
+	if (!(rights & (KingSide | QueenSide)) || !(from & game.getPieces(Us, PieceType::KING) & getSquareMask(King))) {
+		return;
+	}
+	if (game.isSquareAttacked(King, Them)) {
+		return;
+	}
+	Bitboard occupied = game.getOccupied();
+	Bitboard rooks = game.getPieces(Us, PieceType::ROOK);
+	if ((rights & KingSide) && (rooks & getSquareMask(King + 3)) &&
+		!(occupied & (getSquareMask(King + 1) | getSquareMask(King + 2))) &&
+		!game.isSquareAttacked(King + 1, Them) && !game.isSquareAttacked(King + 2, Them)) {
+		list.add(King, King + 2, Move::KING_CASTLE);
+	}
+	if ((rights & QueenSide) && (rooks & getSquareMask(King - 4)) &&
+		!(occupied & (getSquareMask(King - 1) | getSquareMask(King - 2) | getSquareMask(King - 3))) &&
+		!game.isSquareAttacked(King - 1, Them) && !game.isSquareAttacked(King - 2, Them)) {
+		list.add(King, King - 2, Move::QUEEN_CASTLE);
+	}
+}
+
+template<PieceColor Us, GenerationType Type>
+void generateAll(Game& game, MoveList& list, Bitboard from) {
+	Bitboard targets = Type == GenerationType::CAPTURES ? game.getPieces(getOpposite(Us)) :
+		Type == GenerationType::QUIETS ? ~game.getOccupied() : ~game.getPieces(Us);
+	generatePawnMoves<Us, Type>(game, list, from);
+	generatePieceMoves<Us, PieceType::KNIGHT>(game, list, from, targets);
+	generatePieceMoves<Us, PieceType::BISHOP>(game, list, from, targets);
+	generatePieceMoves<Us, PieceType::ROOK>(game, list, from, targets);
+	generatePieceMoves<Us, PieceType::QUEEN>(game, list, from, targets);
+	generatePieceMoves<Us, PieceType::KING>(game, list, from, targets);
+	if (Type != GenerationType::CAPTURES) {
+		generateCastling<Us>(game, list, from);
+	}
+}
+
+template<GenerationType Type>
+void generateMoves(Game& game, PieceColor color, MoveList& list) {
+	PROFILE_SCOPE(MOVE_GENERATION);
+	if (color == PieceColor::WHITE) {
+		generateAll<PieceColor::WHITE, Type>(game, list, ~0ULL);
+	}
+	else {
+		generateAll<PieceColor::BLACK, Type>(game, list, ~0ULL);
+	}
+}
+
+template void generateMoves<GenerationType::CAPTURES>(Game& game, PieceColor color, MoveList& list);
+template void generateMoves<GenerationType::QUIETS>(Game& game, PieceColor color, MoveList& list);
+template void generateMoves<GenerationType::ALL>(Game& game, PieceColor color, MoveList& list);
+
+void generateMoves(Game& game, int square, MoveList& list) {
+	PROFILE_SCOPE(MOVE_GENERATION);
+	Bitboard from = getSquareMask(square);
+	if (game.getPieces(PieceColor::WHITE) & from) {
+		generateAll<PieceColor::WHITE, GenerationType::ALL>(game, list, from);
+	}
+	else if (game.getPieces(PieceColor::BLACK) & from) {
+		generateAll<PieceColor::BLACK, GenerationType::ALL>(game, list, from);
+	}
+}
+
+bool isLegal(Game& game, Move move) {
+	PieceColor color = (game.getPieces(PieceColor::WHITE) & getSquareMask(move.getFrom())) ? PieceColor::WHITE : PieceColor::BLACK;
+	UndoInfo undo = game.makeMove(move);
+	Bitboard king = game.getPieces(color, PieceType::KING);
+	bool legal = king && !game.isSquareAttacked(getLowestSquare(king), getOpposite(color));
+	game.unmakeMove(move, undo);
+	return legal;
+}
+
+bool isPseudoLegal(Game& game, Move move) {
+	Piece piece = game.getPiece(move.getFrom());
+	if (piece.isEmpty() || piece.getColor() != game.getCurrentTurn()) {
+		return false;
+	}
+	MoveList moves;
+	generateMoves(game, move.getFrom(), moves);
+	return moves.contains(move);
+}
+
+// Squares strictly between two squares on a line, empty when they don't share one
+inline Bitboard getSquaresBetween(int from, int to) {
+	Bitboard fromMask = getSquareMask(from), toMask = getSquareMask(to);
+	if (getRookAttacks(from, 0) & toMask) {
+		return getRookAttacks(from, toMask) & getRookAttacks(to, fromMask);
+	}
+	if (getBishopAttacks(from, 0) & toMask) {
+		return getBishopAttacks(from, toMask) & getBishopAttacks(to, fromMask);
+	}
+	return 0;
+}
+
+// Pieces that are neither the king nor pinned only need a target that deals
+// with any check, so most positions are answered from attack sets alone. Pinned
+// pieces and en passant, which can uncover the king, are tried move by move.
+// Castling never matters since the king could instead step to the square it
+// would pass through.
+bool hasLegalMove(Game& game, PieceColor color) {
+	PieceColor them = getOpposite(color);
+	Bitboard ours = game.getPieces(color), enemies = game.getPieces(them), occupied = game.getOccupied();
+	Bitboard king = game.getPieces(color, PieceType::KING);
+	if (!king) {
+		return false;
+	}
+	int kingSquare = getLowestSquare(king);
+	Bitboard kingTargets = getKingAttacks(kingSquare) & ~ours;
+	while (kingTargets) {
+		if (!(game.getAttackers(popLowestSquare(kingTargets), occupied ^ king) & enemies)) {
+			return true;
+		}
+	}
+	Bitboard checkers = game.getAttackers(kingSquare, occupied) & enemies;
+	if (popCount(checkers) > 1) {
+		return false;
+	}
+	Bitboard targets = checkers ? getSquaresBetween(kingSquare, getLowestSquare(checkers)) | checkers : ~ours;
+	Bitboard queens = game.getPieces(them, PieceType::QUEEN);
+	Bitboard snipers = (getRookAttacks(kingSquare, 0) & (game.getPieces(them, PieceType::ROOK) | queens)) |
+		(getBishopAttacks(kingSquare, 0) & (game.getPieces(them, PieceType::BISHOP) | queens));
+	Bitboard pinned = 0;
+	while (snipers) {
+		Bitboard blockers = getSquaresBetween(kingSquare, popLowestSquare(snipers)) & occupied;
+		if (popCount(blockers) == 1) {
+			pinned |= blockers & ours;
+		}
+	}
+	Bitboard pieces = ours & ~pinned & ~king;
+	Bitboard pawns = pieces & game.getPieces(color, PieceType::PAWN);
+	pieces &= ~pawns;
+	while (pieces) {
+		int square = popLowestSquare(pieces);
+		Bitboard attacks = 0;
+		switch (game.getPiece(square).getType()) {
+		case PieceType::KNIGHT: attacks = getKnightAttacks(square); break;
+		case PieceType::BISHOP: attacks = getBishopAttacks(square, occupied); break;
+		case PieceType::ROOK: attacks = getRookAttacks(square, occupied); break;
+		default: attacks = getQueenAttacks(square, occupied); break;
+		}
+		if (attacks & targets) {
+			return true;
+		}
+	}
+	bool white = color == PieceColor::WHITE;
+	Bitboard single = (white ? shiftUp(pawns) : shiftDown(pawns)) & ~occupied;
+	Bitboard doubles = single & getRowMask(white ? BOARD_HEIGHT - 3 : 2);
+	doubles = (white ? shiftUp(doubles) : shiftDown(doubles)) & ~occupied;
+	Bitboard captures = white ? shiftUp(shiftLeft(pawns) | shiftRight(pawns)) : shiftDown(shiftLeft(pawns) | shiftRight(pawns));
+	if (((single | doubles) & targets) || (captures & enemies & targets)) {
+		return true;
+	}
+	Bitboard slow = pinned;
+	if (game.getEnPassantSquare() != NO_SQUARE) {
+		slow |= pawns & getPawnAttacks(static_cast<int>(them), game.getEnPassantSquare());
+	}
+	while (slow) {
+		MoveList moves;
+		generateMoves(game, popLowestSquare(slow), moves);
+		for (Move move : moves) {
+			if (isLegal(game, move)) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void filterLegal(Game& game, MoveList& pseudo, MoveList& list) {
+	for (Move move : pseudo) {
+		if (isLegal(game, move)) {
+			list.add(move);
+		}
+	}
+}
+
+void generateLegalMoves(Game& game, PieceColor color, MoveList& list) {
+	MoveList pseudo;
+	generateMoves<GenerationType::ALL>(game, color, pseudo);
+	filterLegal(game, pseudo, list);
+}
+
+void generateLegalMoves(Game& game, int square, MoveList& list) {
+	MoveList pseudo;
+	generateMoves(game, square, pseudo);
+	filterLegal(game, pseudo, list);
+}
\ No newline at end of file
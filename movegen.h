@@ -0,0 +1,26 @@
+#pragma once
+
+#include "move.h"
+
+class Game;
+
+enum class GenerationType {
+	CAPTURES, QUIETS, ALL
+};
+
+// Pseudo-legal moves for every piece of the given color. Captures include
+// promotions, quiets are every other move.
+template<GenerationType Type>
+void generateMoves(Game& game, PieceColor color, MoveList& list);
+
+// Pseudo-legal moves for the single piece standing on the given square.
+void generateMoves(Game& game, int square, MoveList& list);
+
+void generateLegalMoves(Game& game, PieceColor color, MoveList& list);
+void generateLegalMoves(Game& game, int square, MoveList& list);
+bool isLegal(Game& game, Move move);
+// Whether the color has any legal move, stopping at the first one found
+bool hasLegalMove(Game& game, PieceColor color);
+// Whether the move could be generated in this position, used to check moves
+// that come from somewhere else like the transposition table.
+bool isPseudoLegal(Game& game, Move move);
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "movepick.h"
+#include "ai.h"
+#include "game.h"
+#include "movegen.h"
+
+// The king can't really be traded, making it worth more than everything else
+// means a king that recaptures into an attack always comes out behind
+inline int getExchangePieceValue(PieceType type) {
+	return type == PieceType::KING ? 100 * 100 : getMaterialValue(type) * 100;
+}
+
+int getExchangeValue(const Game& game, Move move) {
+	int from = move.getFrom(), to = move.getTo();
+	int gains[32];
+	int depth = 0;
+	PieceType moved = game.getPiece(from).getType();
+	PieceColor side = game.getPiece(from).getColor();
+	Bitboard occupied = game.getOccupied() ^ getSquareMask(from);
+	gains[0] = move.isEnPassant() ? getExchangePieceValue(PieceType::PAWN) : move.isCapture() ? getExchangePieceValue(game.getPiece(to).getType()) : 0;
+	if (move.isEnPassant()) {
+		occupied ^= getSquareMask(to + (side == PieceColor::WHITE ? BOARD_WIDTH : -BOARD_WIDTH));
+	}
+	if (move.isPromotion()) {
+		moved = move.getPromotion();
+		gains[0] += getExchangePieceValue(moved) - getExchangePieceValue(PieceType::PAWN);
+	}
+	Bitboard attackers = game.getAttackers(to, occupied) & occupied;
+	while (true) {
+		side = getOpposite(side);
+		Bitboard ours = attackers & game.getPieces(side);
+		if (!ours || depth + 1 >= 32) {
+			break;
+		}
+		depth++;
+		gains[depth] = getExchangePieceValue(moved) - gains[depth - 1];
+		for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+			Bitboard pieces = ours & game.getPieces(side, static_cast<PieceType>(type));
+			if (pieces) {
+				moved = static_cast<PieceType>(type);
+				occupied ^= pieces & (0 - pieces);
+				break;
+			}
+		}
+		// Removing a piece can uncover a slider lined up behind it
+		attackers = game.getAttackers(to, occupied) & occupied;
+	}
+	while (depth > 0) {
+		gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+		depth--;
+	}
+	return gains[0];
+}
+
+void HistoryTable::update(PieceColor color, Move move, int bonus) {
+	int& score = scores[static_cast<int>(color)][move.getFrom()][move.getTo()];
+	bonus = std::max(-MAX_SCORE, std::min(bonus, MAX_SCORE));
+	score += bonus - score * std::abs(bonus) / MAX_SCORE;
+}
+
+void HistoryTable::clear() {
+	std::fill(scores[0][0], scores[0][0] + COLOR_COUNT * SQUARE_COUNT * SQUARE_COUNT, 0);
+}
+
+MovePicker::MovePicker(Game& game, Move hashMove, const Move* killers, Move counterMove, const HistoryTable& history) :
+	game(game), history(&history), hashMove(hashMove), counterMove(counterMove), stage(Stage::HASH_MOVE) {
+	this->killers[0] = killers[0];
+	this->killers[1] = killers[1];
+	if (hashMove.isNone() || !isPseudoLegal(game, hashMove)) {
+		this->hashMove = Move::none();
+		stage = Stage::GENERATE_CAPTURES;
+	}
+}
+
+bool MovePicker::isSkipped(Move move) const {
+	return move == hashMove || move == killers[0] || move == killers[1];
+}
+
+// One step of a selection sort, so the list is only sorted as far as the
+// search actually gets before cutting off
+Move MovePicker::selectBest() {
+	int best = index;
+	for (int i = index + 1; i < moves.size(); i++) {
+		if (scores[i] > scores[best]) {
+			best = i;
+		}
+	}
+	Move move = moves[best];
+	std::swap(scores[best], scores[index]);
+	*(moves.begin() + best) = moves[index];
+	*(moves.begin() + index) = move;
+	index++;
+	return move;
+}
+
+void MovePicker::scoreCaptures() {
+	for (int i = 0; i < moves.size(); i++) {
+		Move move = moves[i];
+		PieceType victim = move.isEnPassant() ? PieceType::PAWN : game.getPiece(move.getTo()).getType();
+		PieceType attacker = game.getPiece(move.getFrom()).getType();
+		scores[i] = getMaterialValue(victim) * 100 - getMaterialValue(attacker);
+		if (move.isPromotion()) {
+			scores[i] += getMaterialValue(move.getPromotion()) * 100;
+		}
+	}
+}
+
+void MovePicker::scoreQuiets() {
+	PieceColor us = game.getCurrentTurn();
+	for (int i = 0; i < moves.size(); i++) {
+		scores[i] = history->get(us, moves[i]) + (moves[i] == counterMove ? 1 << 20 : 0);
+	}
+}
+
+MovePicker::MovePicker(Game& game, Move hashMove, const HistoryTable& history) :
+	game(game), history(&history), hashMove(hashMove), counterMove(Move::none()), stage(Stage::HASH_MOVE), capturesOnly(true) {
+	killers[0] = killers[1] = Move::none();
+	if (hashMove.isNone() || !(hashMove.isCapture() || hashMove.isPromotion()) || !isPseudoLegal(game, hashMove)) {
+		this->hashMove = Move::none();
+		stage = Stage::GENERATE_CAPTURES;
+	}
+}
+
+Move MovePicker::next() {
+	while (true) {
+		switch (stage) {
+		case Stage::HASH_MOVE:
+			stage = Stage::GENERATE_CAPTURES;
+			return hashMove;
+		case Stage::GENERATE_CAPTURES:
+			moves.clear();
+			generateMoves<GenerationType::CAPTURES>(game, game.getCurrentTurn(), moves);
+			scoreCaptures();
+			index = 0;
+			stage = Stage::CAPTURES;
+			break;
+		case Stage::CAPTURES:
+			while (index < moves.size()) {
+				Move move = selectBest();
+				if (move != hashMove) {
+					return move;
+				}
+			}
+			index = 0;
+			stage = capturesOnly ? Stage::DONE : Stage::KILLERS;
+			break;
+		case Stage::KILLERS:
+			while (index < 2) {
+				Move killer = killers[index++];
+				if (!killer.isNone() && killer != hashMove && !killer.isCapture() && !killer.isPromotion() &&
+					isPseudoLegal(game, killer)) {
+					return killer;
+				}
+			}
+			stage = Stage::GENERATE_QUIETS;
+			break;
+		case Stage::GENERATE_QUIETS:
+			moves.clear();
+			generateMoves<GenerationType::QUIETS>(game, game.getCurrentTurn(), moves);
+			scoreQuiets();
+			index = 0;
+			stage = Stage::QUIETS;
+			break;
+		case Stage::QUIETS:
+			while (index < moves.size()) {
+				Move move = selectBest();
+				if (!isSkipped(move)) {
+					return move;
+				}
+			}
+			stage = Stage::DONE;
+			break;
+		default:
+			return Move::none();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "move.h"
+
+class Game;
+
+// The material the side moving would come out ahead by if both sides keep
+// recapturing on the target square with their least valuable piece, and
+// either side may stop when continuing would lose more. In centipawns.
+int getExchangeValue(const Game& game, Move move);
+
+// How often each quiet move has caused a cutoff, by side and origin/target
+// square. Scores decay towards zero as new bonuses come in, so the table
+// follows what is good in the current part of the tree.
+class HistoryTable {
+private:
+	static constexpr int MAX_SCORE = 16384;
+	int scores[COLOR_COUNT][SQUARE_COUNT][SQUARE_COUNT];
+public:
+	int get(PieceColor color, Move move) const { return scores[static_cast<int>(color)][move.getFrom()][move.getTo()]; }
+	void update(PieceColor color, Move move, int bonus);
+	void clear();
+};
+
+// Hands out moves one at a time in the order most likely to cause a cutoff:
+// the hash move, captures by most valuable victim then least valuable
+// attacker, the two killer moves, then the remaining quiet moves by history
+// and counter move. Each stage is only generated once the previous one runs
+// dry, so a cutoff on the hash move never generates anything. Moves are
+// pseudo-legal, the caller still has to check the king isn't left in check.
+// The quiescence constructor stops after the captures.
+class MovePicker {
+private:
+	enum class Stage {
+		HASH_MOVE, GENERATE_CAPTURES, CAPTURES, KILLERS, GENERATE_QUIETS, QUIETS, DONE
+	};
+	Game& game;
+	const HistoryTable* history;
+	Move hashMove, counterMove;
+	Move killers[2];
+	Stage stage;
+	MoveList moves;
+	int scores[MAX_MOVES];
+	int index = 0;
+	bool capturesOnly = false;
+	bool isSkipped(Move move) const;
+	Move selectBest();
+	void scoreCaptures();
+	void scoreQuiets();
+public:
+	MovePicker(Game& game, Move hashMove, const Move* killers, Move counterMove, const HistoryTable& history);
+	MovePicker(Game& game, Move hashMove, const HistoryTable& history);
+	Move next();
+};
\ No newline at end of file
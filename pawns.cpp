@@ -0,0 +1,100 @@
+#include <algorithm>
+
+#include "pawns.h"
+#include "game.h"
+
+static constexpr Score DOUBLED_PENALTY = { 10, 25 };
+static constexpr Score ISOLATED_PENALTY = { 10, 15 };
+static constexpr Score BACKWARD_PENALTY = { 8, 12 };
+// By rank counted from the pawn's own side
+static constexpr int PASSED_MIDDLEGAME[BOARD_HEIGHT] = { 0, 5, 10, 15, 25, 45, 70, 0 };
+static constexpr int PASSED_ENDGAME[BOARD_HEIGHT] = { 0, 10, 15, 30, 50, 80, 120, 0 };
+// A shield pawn that hasn't moved, one that moved a square, and none at all
+static constexpr int SHELTER_SCORES[] = { 15, 8, -12 };
+
+inline Bitboard getAdjacentColumns(int x) {
+	return (x > 0 ? getColumnMask(x - 1) : 0) | (x < BOARD_WIDTH - 1 ? getColumnMask(x + 1) : 0);
+}
+
+// Rows strictly in front of the given row from the color's point of view
+inline Bitboard getRowsAhead(PieceColor color, int y) {
+	Bitboard above = (1ULL << (y * BOARD_WIDTH)) - 1;
+	return color == PieceColor::WHITE ? above : ~above & ~getRowMask(y);
+}
+
+Score evaluatePawns(PieceColor color, Bitboard ours, Bitboard theirs) {
+	Score score;
+	Bitboard pawns = ours;
+	while (pawns) {
+		int square = popLowestSquare(pawns);
+		int x = square % BOARD_WIDTH, y = square / BOARD_WIDTH;
+		int rank = color == PieceColor::WHITE ? BOARD_HEIGHT - 1 - y : y;
+		Bitboard column = getColumnMask(x), adjacent = getAdjacentColumns(x), ahead = getRowsAhead(color, y);
+		bool isolated = !(ours & adjacent);
+		if (ours & column & ahead) {
+			score -= DOUBLED_PENALTY;
+		}
+		else if (!(theirs & (column | adjacent) & ahead)) {
+			score += Score{ PASSED_MIDDLEGAME[rank], PASSED_ENDGAME[rank] };
+		}
+		if (isolated) {
+			score -= ISOLATED_PENALTY;
+		}
+		// No pawn beside or behind can ever defend it, and it can't advance
+		// without being taken
+		else if (!(ours & adjacent & ~ahead)) {
+			int stop = square + (color == PieceColor::WHITE ? -BOARD_WIDTH : BOARD_WIDTH);
+			if (getPawnAttacks(static_cast<int>(color), stop) & theirs) {
+				score -= BACKWARD_PENALTY;
+			}
+		}
+	}
+	return score;
+}
+
+void fillShelter(PieceColor color, Bitboard ours, int16_t shelter[BOARD_WIDTH]) {
+	int home = color == PieceColor::WHITE ? BOARD_HEIGHT - 2 : 1;
+	int advanced = color == PieceColor::WHITE ? BOARD_HEIGHT - 3 : 2;
+	for (int file = 0; file < BOARD_WIDTH; file++) {
+		int center = std::min(std::max(file, 1), BOARD_WIDTH - 2), value = 0;
+		for (int x = center - 1; x <= center + 1; x++) {
+			Bitboard column = ours & getColumnMask(x);
+			value += SHELTER_SCORES[column & getRowMask(home) ? 0 : column & getRowMask(advanced) ? 1 : 2];
+		}
+		shelter[file] = static_cast<int16_t>(value);
+	}
+}
+
+PawnTable::PawnTable() : entries(new PawnEntry[ENTRY_COUNT]) {
+	clear();
+}
+
+const PawnEntry& PawnTable::probe(const Game& game) {
+	uint64_t key = game.getPawnKey();
+	PawnEntry& entry = entries[key & (ENTRY_COUNT - 1)];
+	probes++;
+	if (entry.key == key) {
+		hits++;
+		return entry;
+	}
+	Bitboard white = game.getPieces(PieceColor::WHITE, PieceType::PAWN), black = game.getPieces(PieceColor::BLACK, PieceType::PAWN);
+	entry.key = key;
+	entry.score = evaluatePawns(PieceColor::WHITE, white, black);
+	entry.score -= evaluatePawns(PieceColor::BLACK, black, white);
+	fillShelter(PieceColor::WHITE, white, entry.shelter[static_cast<int>(PieceColor::WHITE)]);
+	fillShelter(PieceColor::BLACK, black, entry.shelter[static_cast<int>(PieceColor::BLACK)]);
+	return entry;
+}
+
+// Positions without pawns really have a key of zero, so empty entries need a
+// key that can't come up in practice
+void PawnTable::clear() {
+	for (int i = 0; i < ENTRY_COUNT; i++) {
+		entries[i].key = ~0ULL;
+	}
+}
+
+void PawnTable::resetStatistics() {
+	probes = 0;
+	hits = 0;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "eval.h"
+
+class Game;
+
+// The pawn structure terms of one pawn configuration, positive values favor
+// white. The king shelter depends on where the king stands, so it is kept for
+// every file the king could be on and picked when evaluating.
+struct PawnEntry {
+	uint64_t key;
+	Score score;
+	int16_t shelter[COLOR_COUNT][BOARD_WIDTH];
+};
+
+// Caches pawn structure evaluations by the pawn-only key. Pawns move much less
+// often than anything else, so nearly every probe hits. Each search thread
+// owns a table, so entries need no locking.
+class PawnTable {
+private:
+	static constexpr int ENTRY_COUNT = 1 << 14;
+	std::unique_ptr<PawnEntry[]> entries;
+	uint64_t probes = 0, hits = 0;
+public:
+	PawnTable();
+	const PawnEntry& probe(const Game& game);
+	void clear();
+	uint64_t getProbes() const { return probes; }
+	uint64_t getHits() const { return hits; }
+	void resetStatistics();
+};
\ No newline at end of file
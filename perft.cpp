@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "perft.h"
+#include "game.h"
+#include "movegen.h"
+
+PerftTable::PerftTable(size_t megabytes) {
+	size_t count = 1;
+	while (count * 2 * sizeof(Entry) <= megabytes * 1024 * 1024) {
+		count *= 2;
+	}
+	entries.reset(new Entry[count]);
+	for (size_t i = 0; i < count; i++) {
+		entries[i].check = 0;
+		entries[i].data = 0;
+	}
+	mask = count - 1;
+}
+
+bool PerftTable::probe(uint64_t key, int depth, uint64_t& nodes) {
+	Entry& entry = entries[key & mask];
+	uint64_t data = entry.data.load(std::memory_order_relaxed);
+	uint64_t check = entry.check.load(std::memory_order_relaxed);
+	if ((check ^ data) != key || static_cast<int>(data & 63) != depth) {
+		return false;
+	}
+	nodes = data >> 6;
+	return true;
+}
+
+void PerftTable::store(uint64_t key, int depth, uint64_t nodes) {
+	Entry& entry = entries[key & mask];
+	uint64_t data = nodes << 6 | static_cast<uint64_t>(depth);
+	entry.check.store(key ^ data, std::memory_order_relaxed);
+	entry.data.store(data, std::memory_order_relaxed);
+}
+
+uint64_t perft(Game& game, int depth) {
+	return perft(game, depth, nullptr);
+}
+
+uint64_t perft(Game& game, int depth, PerftTable* table) {
+	MoveList moves;
+	generateLegalMoves(game, game.getCurrentTurn(), moves);
+	if (depth <= 1) {
+		return depth == 1 ? moves.size() : 1;
+	}
+	uint64_t key = 0, nodes = 0;
+	if (table) {
+		key = game.getKey();
+		if (table->probe(key, depth, nodes)) {
+			return nodes;
+		}
+	}
+	for (Move move : moves) {
+		UndoInfo undo = game.makeMove(move);
+		nodes += perft(game, depth - 1, table);
+		game.unmakeMove(move, undo);
+	}
+	if (table) {
+		table->store(key, depth, nodes);
+	}
+	return nodes;
+}
+
+PerftResult runPerft(Game& game, const PerftOptions& options) {
+	PerftResult result;
+	std::unique_ptr<PerftTable> table;
+	if (options.hashMegabytes > 0) {
+		table.reset(new PerftTable(options.hashMegabytes));
+	}
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	MoveList moves;
+	generateLegalMoves(game, game.getCurrentTurn(), moves);
+	result.divide.resize(moves.size());
+	// Root moves are handed out one at a time so threads that finish small
+	// subtrees early pick up the remaining work
+	std::atomic<int> next(0);
+	auto worker = [&]() {
+		Game copy = game;
+		int index;
+		while ((index = next++) < moves.size()) {
+			Move move = moves[index];
+			UndoInfo undo = copy.makeMove(move);
+			result.divide[index] = std::make_pair(move, perft(copy, options.depth - 1, table.get()));
+			copy.unmakeMove(move, undo);
+		}
+	};
+	std::vector<std::thread> threads;
+	for (int i = 1; i < std::max(1, options.threads); i++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	for (const std::pair<Move, uint64_t>& entry : result.divide) {
+		result.nodes += entry.second;
+	}
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+const std::vector<PerftPosition>& getPerftSuite() {
+	static const std::vector<PerftPosition> suite = {
+		{ "Initial position", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+			{ 20, 400, 8902, 197281, 4865609, 119060324 } },
+		{ "Kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+			{ 48, 2039, 97862, 4085603, 193690690 } },
+		{ "Rook endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+			{ 14, 191, 2812, 43238, 674624, 11030083 } },
+		{ "Promotions", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+			{ 6, 264, 9467, 422333, 15833292 } },
+		{ "Discovered checks", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+			{ 44, 1486, 62379, 2103487, 89941194 } },
+		{ "Middlegame", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+			{ 46, 2079, 89890, 3894594, 164075551 } }
+	};
+	return suite;
+}
+
+const std::vector<FenCheck>& getFenChecks() {
+	static const std::vector<FenCheck> checks = {
+		{ "No kings", "8/8/8/8/8/8/8/8 w - - 0 1", nullptr },
+		{ "Missing black king", "8/8/8/8/8/8/8/4K3 w - - 0 1", nullptr },
+		{ "Two white kings", "4k3/8/8/8/8/8/8/3KK3 w - - 0 1", nullptr },
+		{ "En passant without a pawn", "4k3/8/8/3P4/8/8/8/4K3 w - e6 0 1", "4k3/8/8/3P4/8/8/8/4K3 w - - 0 1" },
+		{ "En passant on the wrong rank", "4k3/8/8/3Pp3/8/8/8/4K3 w - e3 0 1", "4k3/8/8/3Pp3/8/8/8/4K3 w - - 0 1" },
+		{ "En passant onto a piece", "4k3/8/4n3/3Pp3/8/8/8/4K3 w - e6 0 1", "4k3/8/4n3/3Pp3/8/8/8/4K3 w - - 0 1" },
+		{ "En passant", "4k3/8/8/3Pp3/8/8/8/4K3 w - e6 0 1", "4k3/8/8/3Pp3/8/8/8/4K3 w - e6 0 1" }
+	};
+	return checks;
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "move.h"
+
+class Game;
+
+// Caches subtree node counts by position so transposed subtrees are only
+// counted once. Entries are stored as two words with the key XORed into the
+// first, so concurrent writers can only ever produce a miss, never a wrong hit.
+class PerftTable {
+private:
+	struct Entry {
+		std::atomic<uint64_t> check, data;
+	};
+	std::unique_ptr<Entry[]> entries;
+	size_t mask;
+public:
+	explicit PerftTable(size_t megabytes);
+	bool probe(uint64_t key, int depth, uint64_t& nodes);
+	void store(uint64_t key, int depth, uint64_t nodes);
+};
+
+struct PerftOptions {
+	int depth = 1;
+	int threads = 1;
+	size_t hashMegabytes = 0;
+};
+
+struct PerftResult {
+	uint64_t nodes = 0;
+	double seconds = 0;
+	std::vector<std::pair<Move, uint64_t>> divide;
+	uint64_t getNodesPerSecond() const { return seconds > 0 ? static_cast<uint64_t>(nodes / seconds) : 0; }
+};
+
+struct PerftPosition {
+	const char* name;
+	const char* fen;
+	std::vector<uint64_t> nodes;
+};
+
+uint64_t perft(Game& game, int depth);
+uint64_t perft(Game& game, int depth, PerftTable* table);
+PerftResult runPerft(Game& game, const PerftOptions& options);
+// A record fromFEN has to reject, or accept as the cleaned up FEN given
+struct FenCheck {
+	const char* name;
+	const char* fen;
+	const char* expected;
+};
+
+const std::vector<PerftPosition>& getPerftSuite();
+const std::vector<FenCheck>& getFenChecks();
\ No newline at end of file
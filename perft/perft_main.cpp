@@ -0,0 +1,121 @@
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "../bitboard.h"
+#include "../game.h"
+#include "../perft.h"
+#include "../profile.h"
+
+static const char* USAGE =
+"Usage: perft [options]\n"
+"  --fen <fen>        Position to count from (default: the initial position)\n"
+"  --depth <n>        Depth to count to (default: 5)\n"
+"  --divide           Print the node count below every root move\n"
+"  --threads <n>      Split the root moves across n threads (default: 1)\n"
+"  --hash <mb>        Cache subtree counts in a table of the given size\n"
+"  --suite            Check the reference positions, exits with 1 on a mismatch\n"
+"  --max-depth <n>    Deepest suite depth to check (default: 4)\n"
+"  --no-pext          Look up sliding attacks with magic multiplies even on BMI2 CPUs\n";
+
+void printResult(const PerftResult& result) {
+	std::cout << result.nodes << " nodes in " << std::fixed << std::setprecision(3) << result.seconds << "s ("
+		<< result.getNodesPerSecond() << " nodes per second)" << std::endl;
+}
+
+int runSuite(PerftOptions options, int maxDepth) {
+	int failures = 0;
+	uint64_t totalNodes = 0;
+	double totalSeconds = 0;
+	for (const PerftPosition& position : getPerftSuite()) {
+		Game game;
+		game.fromFEN(position.fen);
+		std::cout << position.name << " (" << position.fen << ")" << std::endl;
+		for (int depth = 1; depth <= maxDepth && depth <= static_cast<int>(position.nodes.size()); depth++) {
+			options.depth = depth;
+			PerftResult result = runPerft(game, options);
+			uint64_t expected = position.nodes.at(depth - 1);
+			bool correct = result.nodes == expected;
+			failures += correct ? 0 : 1;
+			totalNodes += result.nodes;
+			totalSeconds += result.seconds;
+			std::cout << "  depth " << depth << ": " << (correct ? "ok   " : "FAIL ");
+			if (!correct) {
+				std::cout << "(expected " << expected << ") ";
+			}
+			printResult(result);
+		}
+	}
+	for (const FenCheck& check : getFenChecks()) {
+		Game game;
+		bool accepted = game.fromFEN(check.fen);
+		bool correct = check.expected == nullptr ? !accepted : accepted && game.toFEN() == check.expected;
+		failures += correct ? 0 : 1;
+		std::cout << check.name << " (" << check.fen << "): " << (correct ? "ok" : "FAIL") << std::endl;
+	}
+	std::cout << std::endl << "Total: " << totalNodes << " nodes in " << std::fixed << std::setprecision(3) << totalSeconds << "s ("
+		<< static_cast<uint64_t>(totalSeconds > 0 ? totalNodes / totalSeconds : 0) << " nodes per second), "
+		<< failures << " failures" << std::endl;
+	return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+	PROFILE_START();
+	PerftOptions options;
+	options.depth = 5;
+	std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+	bool divide = false, suite = false;
+	int maxDepth = 4;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (argument == "--fen" && hasValue) {
+			fen = argv[++i];
+		}
+		else if (argument == "--depth" && hasValue) {
+			options.depth = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (argument == "--threads" && hasValue) {
+			options.threads = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (argument == "--hash" && hasValue) {
+			options.hashMegabytes = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+		}
+		else if (argument == "--max-depth" && hasValue) {
+			maxDepth = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (argument == "--divide") {
+			divide = true;
+		}
+		else if (argument == "--suite") {
+			suite = true;
+		}
+		else if (argument == "--no-pext") {
+			setPextEnabled(false);
+		}
+		else {
+			std::cerr << USAGE;
+			return 2;
+		}
+	}
+	std::cout << "Sliding attacks: " << (isPextEnabled() ? "PEXT" : "magic") << std::endl;
+	if (suite) {
+		return runSuite(options, maxDepth);
+	}
+	Game game;
+	if (!game.fromFEN(fen)) {
+		std::cerr << "Invalid FEN: " << fen << std::endl;
+		return 2;
+	}
+	PerftResult result = runPerft(game, options);
+	if (divide) {
+		for (const std::pair<Move, uint64_t>& entry : result.divide) {
+			std::cout << entry.first.toString() << ": " << entry.second << std::endl;
+		}
+		std::cout << std::endl;
+	}
+	printResult(result);
+	return 0;
+}
\ No newline at end of file
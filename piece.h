@@ -1,42 +1,63 @@
 #pragma once
 
-#include <string>
+#include <cstdint>
 #include <vector>
 
 #include "point.h"
 
 class Game;
-class PieceType {
-private:
-	std::string displayCharacter, name;
-public:
-	static const PieceType PAWN, ROOK, KNIGHT, BISHOP, QUEEN, KING, EMPTY;
-	PieceType(std::string displayCharacter, std::string name) :
-		displayCharacter(displayCharacter), name(name) {}
-	bool operator==(PieceType piece) { return getDisplayCharacter() == piece.getDisplayCharacter(); }
-	bool operator<(const PieceType& piece) const { return getDisplayCharacter().at(0) < piece.getDisplayCharacter().at(0); }
-	std::string getDisplayCharacter() const { return displayCharacter; }
-	std::string getName() { return name; }
+
+static constexpr int PIECE_TYPE_COUNT = 6;
+
+enum class PieceType : uint8_t {
+	PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING, EMPTY
 };
 
-enum class PieceColor {
+enum class PieceColor : uint8_t {
 	WHITE, BLACK
 };
 
+inline constexpr PieceColor getOpposite(PieceColor color) {
+	return color == PieceColor::WHITE ? PieceColor::BLACK : PieceColor::WHITE;
+}
+
+inline const char* getDisplayCharacter(PieceType type) {
+	static constexpr const char* characters[] = { "P", "N", "B", "R", "Q", "K", " " };
+	return characters[static_cast<int>(type)];
+}
+
+inline const char* getName(PieceType type) {
+	static constexpr const char* names[] = { "Pawn", "Knight", "Bishop", "Rook", "Queen", "King", "" };
+	return names[static_cast<int>(type)];
+}
+
+inline PieceType getPieceType(char character) {
+	for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+		char display = getDisplayCharacter(static_cast<PieceType>(type))[0];
+		if (character == display || character == display - 'A' + 'a') {
+			return static_cast<PieceType>(type);
+		}
+	}
+	return PieceType::EMPTY;
+}
+
+// A piece packed into one byte: three bits of type, one bit of color and one
+// bit remembering whether the piece has moved yet.
 class Piece {
 private:
-	PieceType type;
-	PieceColor color;
-	bool firstMove = true;
-	void lookInDirection(Game& game, std::vector<Point>& result, Point location, int right, int up, int max);
+	static constexpr uint8_t COLOR_BIT = 8, FIRST_MOVE_BIT = 16;
+	uint8_t code;
 public:
-	Piece() : type(PieceType::EMPTY), color(PieceColor::WHITE) {}
-	Piece(PieceType type, PieceColor color) : type(type), color(color) {}
-	bool operator==(Piece& piece) { return getType() == piece.getType() && getColor() == piece.getColor(); }
-	PieceType getType() { return type; }
-	PieceColor getColor() { return color; }
+	constexpr Piece() : code(static_cast<uint8_t>(PieceType::EMPTY) | FIRST_MOVE_BIT) {}
+	constexpr Piece(PieceType type, PieceColor color) :
+		code(static_cast<uint8_t>(static_cast<uint8_t>(type) | static_cast<uint8_t>(color) << 3 | FIRST_MOVE_BIT)) {}
+	constexpr bool operator==(Piece piece) const { return (code & ~FIRST_MOVE_BIT) == (piece.code & ~FIRST_MOVE_BIT); }
+	constexpr bool operator!=(Piece piece) const { return !(*this == piece); }
+	constexpr PieceType getType() const { return static_cast<PieceType>(code & 7); }
+	constexpr PieceColor getColor() const { return static_cast<PieceColor>((code & COLOR_BIT) >> 3); }
+	constexpr bool isEmpty() const { return getType() == PieceType::EMPTY; }
 	std::vector<Point> getValidMoves(Game& game, Point location);
 	std::vector<Point> getMoves(Game& game, Point location);
-	bool isFirstMove() { return firstMove; }
-	void setFirstMove(bool first) { firstMove = first; }
+	constexpr bool isFirstMove() const { return (code & FIRST_MOVE_BIT) != 0; }
+	void setFirstMove(bool first) { code = static_cast<uint8_t>(first ? code | FIRST_MOVE_BIT : code & ~FIRST_MOVE_BIT); }
 };
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "profile.h"
+
+#if defined(CHESS_PROFILE)
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+static constexpr int SECTION_COUNT = static_cast<int>(ProfileSection::COUNT);
+static constexpr int COUNTER_COUNT = static_cast<int>(ProfileCounter::COUNT);
+// Bucket n counts the calls that took from 2^n up to 2^(n+1) nanoseconds
+static constexpr int HISTOGRAM_SIZE = 40;
+static constexpr size_t TRACE_EVENT_LIMIT = 100000;
+
+static constexpr const char* SECTION_NAMES[SECTION_COUNT] = {
+	"generateMoves", "makeMove", "unmakeMove", "evaluate", "probe", "search", "iteration", "getValidMoves"
+};
+static constexpr bool SECTION_TRACED[SECTION_COUNT] = {
+	false, false, false, false, false, true, true, true
+};
+static constexpr const char* COUNTER_NAMES[COUNTER_COUNT] = { "nodes", "tableHits" };
+
+struct TraceEvent {
+	ProfileSection section;
+	uint64_t start, end;
+};
+
+struct RateSample {
+	uint64_t time, nodesPerSecond;
+	double hitRate;
+};
+
+// Only its own thread writes to it, the atomics just let the reports read it
+// while the search is running
+struct ThreadProfile {
+	int id = 0;
+	std::atomic<uint64_t> calls[SECTION_COUNT] = {}, time[SECTION_COUNT] = {};
+	std::atomic<uint64_t> histogram[SECTION_COUNT][HISTOGRAM_SIZE] = {};
+	std::atomic<uint64_t> counters[COUNTER_COUNT] = {};
+	std::mutex eventMutex;
+	std::vector<TraceEvent> events;
+};
+
+// Thread profiles outlive their threads so nothing counted is lost, and the
+// registry itself is never freed since threads may still record while the
+// program exits
+struct ProfileRegistry {
+	std::mutex mutex;
+	std::vector<ThreadProfile*> threads;
+	std::vector<RateSample> samples;
+	uint64_t epoch = getProfileTime();
+	std::atomic<uint64_t> lastReport{ 0 };
+	uint64_t lastNodes = 0, lastProbes = 0, lastHits = 0;
+};
+
+static ProfileRegistry& getRegistry() {
+	static ProfileRegistry* registry = new ProfileRegistry();
+	return *registry;
+}
+
+static ThreadProfile& getThreadProfile() {
+	static thread_local ThreadProfile* profile = nullptr;
+	if (profile == nullptr) {
+		ProfileRegistry& registry = getRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		profile = new ThreadProfile();
+		profile->id = static_cast<int>(registry.threads.size());
+		registry.threads.push_back(profile);
+	}
+	return *profile;
+}
+
+inline void increment(std::atomic<uint64_t>& value, uint64_t amount) {
+	value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+void recordProfileSection(ProfileSection section, uint64_t start, uint64_t end) {
+	ThreadProfile& profile = getThreadProfile();
+	int index = static_cast<int>(section);
+	uint64_t duration = end - start;
+	int bucket = 0;
+	while (bucket < HISTOGRAM_SIZE - 1 && duration >> (bucket + 1) != 0) {
+		bucket++;
+	}
+	increment(profile.calls[index], 1);
+	increment(profile.time[index], duration);
+	increment(profile.histogram[index][bucket], 1);
+	if (SECTION_TRACED[index]) {
+		std::lock_guard<std::mutex> lock(profile.eventMutex);
+		if (profile.events.size() < TRACE_EVENT_LIMIT) {
+			profile.events.push_back({ section, start, end });
+		}
+	}
+}
+
+void addProfileCount(ProfileCounter counter, uint64_t amount) {
+	increment(getThreadProfile().counters[static_cast<int>(counter)], amount);
+}
+
+static uint64_t getTotalCalls(ProfileRegistry& registry, ProfileSection section) {
+	uint64_t total = 0;
+	for (ThreadProfile* profile : registry.threads) {
+		total += profile->calls[static_cast<int>(section)].load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+static uint64_t getTotalCount(ProfileRegistry& registry, ProfileCounter counter) {
+	uint64_t total = 0;
+	for (ThreadProfile* profile : registry.threads) {
+		total += profile->counters[static_cast<int>(counter)].load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+void reportProfile() {
+	ProfileRegistry& registry = getRegistry();
+	uint64_t now = getProfileTime();
+	uint64_t last = registry.lastReport.load(std::memory_order_relaxed);
+	if (now - last < static_cast<uint64_t>(PROFILE_REPORT_INTERVAL) * 1000000 ||
+		!registry.lastReport.compare_exchange_strong(last, now)) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	uint64_t nodes = getTotalCount(registry, ProfileCounter::NODES);
+	uint64_t probes = getTotalCalls(registry, ProfileSection::TABLE_PROBE);
+	uint64_t hits = getTotalCount(registry, ProfileCounter::TABLE_HITS);
+	RateSample sample;
+	sample.time = now;
+	sample.nodesPerSecond = (nodes - registry.lastNodes) * 1000000000 / (now - last);
+	sample.hitRate = probes > registry.lastProbes ? static_cast<double>(hits - registry.lastHits) / (probes - registry.lastProbes) : 0;
+	registry.samples.push_back(sample);
+	registry.lastNodes = nodes;
+	registry.lastProbes = probes;
+	registry.lastHits = hits;
+	std::cerr << "profile: " << sample.nodesPerSecond << " nps, " << std::fixed << std::setprecision(1)
+		<< 100 * sample.hitRate << "% hash hits, " << nodes << " nodes" << std::endl;
+}
+
+// Percentiles are only as exact as the histogram, so they give the upper end
+// of the bucket they fall in
+static uint64_t getPercentile(const uint64_t* histogram, uint64_t calls, double fraction) {
+	uint64_t seen = 0;
+	for (int bucket = 0; bucket < HISTOGRAM_SIZE; bucket++) {
+		seen += histogram[bucket];
+		if (seen > 0 && seen >= fraction * calls) {
+			return 2ULL << bucket;
+		}
+	}
+	return 2ULL << (HISTOGRAM_SIZE - 1);
+}
+
+std::string getProfileSummary() {
+	ProfileRegistry& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	std::ostringstream out;
+	out << std::setw(14) << std::left << "Section" << std::right << std::setw(14) << "Calls" << std::setw(12) << "Total ms"
+		<< std::setw(14) << "Mean ns" << std::setw(14) << "p50 ns" << std::setw(14) << "p99 ns" << std::endl;
+	for (int i = 0; i < SECTION_COUNT; i++) {
+		uint64_t calls = 0, time = 0, histogram[HISTOGRAM_SIZE] = {};
+		for (ThreadProfile* profile : registry.threads) {
+			calls += profile->calls[i].load(std::memory_order_relaxed);
+			time += profile->time[i].load(std::memory_order_relaxed);
+			for (int bucket = 0; bucket < HISTOGRAM_SIZE; bucket++) {
+				histogram[bucket] += profile->histogram[i][bucket].load(std::memory_order_relaxed);
+			}
+		}
+		if (calls == 0) {
+			continue;
+		}
+		out << std::setw(14) << std::left << SECTION_NAMES[i] << std::right << std::setw(14) << calls
+			<< std::setw(12) << time / 1000000 << std::setw(14) << time / calls
+			<< std::setw(14) << getPercentile(histogram, calls, 0.5) << std::setw(14) << getPercentile(histogram, calls, 0.99) << std::endl;
+	}
+	for (int i = 0; i < COUNTER_COUNT; i++) {
+		out << COUNTER_NAMES[i] << ": " << getTotalCount(registry, static_cast<ProfileCounter>(i)) << std::endl;
+	}
+	return out.str();
+}
+
+// Chrome trace_event format, timestamps in microseconds since the profile
+// started. Load it in chrome://tracing or Perfetto.
+bool writeProfileTrace(const std::string& path) {
+	ProfileRegistry& registry = getRegistry();
+	std::ofstream file(path);
+	if (!file) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	auto toMicroseconds = [&registry](uint64_t time) {
+		return time > registry.epoch ? (time - registry.epoch) / 1000.0 : 0.0;
+	};
+	file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+	bool first = true;
+	auto separate = [&file, &first]() {
+		file << (first ? "\n" : ",\n");
+		first = false;
+	};
+	for (ThreadProfile* profile : registry.threads) {
+		separate();
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << profile->id
+			<< ",\"args\":{\"name\":\"thread " << profile->id << "\"}}";
+		std::lock_guard<std::mutex> eventLock(profile->eventMutex);
+		for (const TraceEvent& event : profile->events) {
+			separate();
+			file << "{\"name\":\"" << SECTION_NAMES[static_cast<int>(event.section)] << "\",\"cat\":\"engine\",\"ph\":\"X\",\"pid\":1,\"tid\":" << profile->id
+				<< ",\"ts\":" << toMicroseconds(event.start) << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+		}
+	}
+	for (const RateSample& sample : registry.samples) {
+		separate();
+		file << "{\"name\":\"search rate\",\"ph\":\"C\",\"pid\":1,\"ts\":" << toMicroseconds(sample.time)
+			<< ",\"args\":{\"nps\":" << sample.nodesPerSecond << ",\"hash hit %\":" << 100 * sample.hitRate << "}}";
+	}
+	file << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+	return static_cast<bool>(file);
+}
+
+static void finishProfiling() {
+	std::cerr << getProfileSummary();
+	if (writeProfileTrace(PROFILE_TRACE_PATH)) {
+		std::cerr << "Trace written to " << PROFILE_TRACE_PATH << std::endl;
+	}
+}
+
+void startProfiling() {
+	ProfileRegistry& registry = getRegistry();
+	registry.lastReport = getProfileTime();
+	std::atexit(finishProfiling);
+}
+
+#endif
\ No newline at end of file
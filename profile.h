@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Instrumentation of the hot paths, compiled in only when CHESS_PROFILE is
+// defined. Without it every PROFILE_ macro expands to nothing, so the engine
+// pays nothing for it.
+//
+// Each thread keeps its own call counts, total times and latency histograms,
+// so recording never touches a shared cache line. Sections marked as traced
+// are also kept as Chrome trace events; the hot sections are only counted,
+// since tracing every move made would dwarf the search itself. The whole
+// profile is written out when the program exits.
+static constexpr const char* PROFILE_TRACE_PATH = "trace.json";
+static constexpr int PROFILE_REPORT_INTERVAL = 1000;
+
+enum class ProfileSection {
+	MOVE_GENERATION, MAKE_MOVE, UNMAKE_MOVE, EVALUATION, TABLE_PROBE,
+	SEARCH, ITERATION, VALID_MOVES, COUNT
+};
+
+enum class ProfileCounter {
+	NODES, TABLE_HITS, COUNT
+};
+
+#if defined(CHESS_PROFILE)
+
+#include <chrono>
+
+inline uint64_t getProfileTime() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void recordProfileSection(ProfileSection section, uint64_t start, uint64_t end);
+void addProfileCount(ProfileCounter counter, uint64_t amount);
+// Prints the nodes per second and hash hit rate since the last report to
+// standard error, at most once every PROFILE_REPORT_INTERVAL milliseconds
+void reportProfile();
+std::string getProfileSummary();
+bool writeProfileTrace(const std::string& path);
+// Writes the trace and the final summary when the program exits
+void startProfiling();
+
+class ProfileScope {
+private:
+	ProfileSection section;
+	uint64_t start;
+public:
+	explicit ProfileScope(ProfileSection section) : section(section), start(getProfileTime()) {}
+	~ProfileScope() { recordProfileSection(section, start, getProfileTime()); }
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define PROFILE_SCOPE(section) ProfileScope profileScope(ProfileSection::section)
+#define PROFILE_COUNT(counter, amount) addProfileCount(ProfileCounter::counter, amount)
+#define PROFILE_REPORT() reportProfile()
+#define PROFILE_START() startProfiling()
+
+#else
+
+#define PROFILE_SCOPE(section) ((void)0)
+#define PROFILE_COUNT(counter, amount) ((void)0)
+#define PROFILE_REPORT() ((void)0)
+#define PROFILE_START() ((void)0)
+
+#endif
\ No newline at end of file
@@ -1,6 +1,5 @@
 #include "main.h"
 
-int main() {
-	start();
-	return 0;
+int main(int argc, char** argv) {
+	return start(argc, argv);
 }
\ No newline at end of file
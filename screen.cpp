@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cstring>
+
+#include "screen.h"
+
+static constexpr const char* ESCAPE_RESET = "\033[0m";
+static constexpr int SHORT_GAP = 4;
+
+bool ScreenCell::operator==(const ScreenCell& other) const {
+	return length == other.length && style == other.style && std::memcmp(glyph, other.glyph, length) == 0;
+}
+
+inline size_t getGlyphLength(unsigned char lead) {
+	return lead < 0x80 ? 1 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+}
+
+const ScreenCell& getCell(const std::vector<std::vector<ScreenCell>>& rows, size_t x, size_t y) {
+	static const ScreenCell blank;
+	return y < rows.size() && x < rows[y].size() ? rows[y][x] : blank;
+}
+
+// Whether the cells between the columns are all drawn in the given style
+bool isPlain(const std::vector<std::vector<ScreenCell>>& rows, size_t from, size_t to, size_t y, int style) {
+	for (size_t x = from; x < to; x++) {
+		if (getCell(rows, x, y).style != style) {
+			return false;
+		}
+	}
+	return true;
+}
+
+uint8_t Screen::getStyle(const char* foreground, const char* background) {
+	foreground = foreground ? foreground : "";
+	background = background ? background : "";
+	size_t foregroundLength = std::strlen(foreground), backgroundLength = std::strlen(background);
+	for (size_t i = 0; i < styles.size(); i++) {
+		const std::string& style = styles[i];
+		if (style.size() == foregroundLength + backgroundLength && style.compare(0, foregroundLength, foreground) == 0 &&
+			style.compare(foregroundLength, backgroundLength, background) == 0) {
+			return static_cast<uint8_t>(i);
+		}
+	}
+	if (styles.size() > UINT8_MAX) {
+		return 0;
+	}
+	styles.push_back(std::string(foreground) + background);
+	return static_cast<uint8_t>(styles.size() - 1);
+}
+
+int Screen::writeGlyphs(int x, int y, const char* text, size_t length, uint8_t style) {
+	if (x < 0 || y < 0) {
+		return x;
+	}
+	if (cells.size() <= static_cast<size_t>(y)) {
+		cells.resize(y + 1);
+	}
+	std::vector<ScreenCell>& row = cells[y];
+	for (size_t i = 0; i < length; x++) {
+		if (row.size() <= static_cast<size_t>(x)) {
+			row.resize(x + 1);
+		}
+		ScreenCell& cell = row[x];
+		cell.length = static_cast<uint8_t>(std::min(getGlyphLength(static_cast<unsigned char>(text[i])), length - i));
+		std::memcpy(cell.glyph, text + i, cell.length);
+		cell.style = style;
+		i += cell.length;
+	}
+	return x;
+}
+
+void Screen::clear() {
+	cells.clear();
+}
+
+int Screen::write(int x, int y, const char* text, const char* foreground, const char* background) {
+	return writeGlyphs(x, y, text, std::strlen(text), getStyle(foreground, background));
+}
+
+int Screen::write(int x, int y, const std::string& text, const char* foreground, const char* background) {
+	return writeGlyphs(x, y, text.data(), text.size(), getStyle(foreground, background));
+}
+
+void Screen::writeText(int x, int y, const std::string& text) {
+	std::string escapes;
+	uint8_t style = 0;
+	int column = x;
+	size_t start = 0;
+	while (start < text.size()) {
+		size_t end = text.find_first_of("\n\033", start);
+		end = end == std::string::npos ? text.size() : end;
+		column = writeGlyphs(column, y, text.data() + start, end - start, style);
+		if (end == text.size()) {
+			break;
+		}
+		if (text[end] == '\n') {
+			column = x;
+			y++;
+			start = end + 1;
+			continue;
+		}
+		size_t finish = text.find('m', end);
+		finish = finish == std::string::npos ? text.size() - 1 : finish;
+		std::string escape = text.substr(end, finish - end + 1);
+		escapes = escape == ESCAPE_RESET ? "" : escapes + escape;
+		style = getStyle(escapes.c_str(), nullptr);
+		start = finish + 1;
+	}
+}
+
+std::string Screen::render() {
+	std::string output;
+	// The style the terminal is drawing in, unknown until the first reset
+	int active = -1;
+	if (!valid) {
+		output += ESCAPE_RESET;
+		output += "\033[2J";
+		shown.clear();
+		active = 0;
+	}
+	int cursorX = -1, cursorY = -1;
+	size_t height = std::max(cells.size(), shown.size());
+	for (size_t y = 0; y < height; y++) {
+		size_t width = std::max(y < cells.size() ? cells[y].size() : 0, y < shown.size() ? shown[y].size() : 0);
+		for (size_t x = 0; x < width; x++) {
+			const ScreenCell& cell = getCell(cells, x, y);
+			if (cell == getCell(shown, x, y)) {
+				continue;
+			}
+			if (static_cast<int>(y) == cursorY && static_cast<int>(x) > cursorX && static_cast<int>(x) - cursorX <= SHORT_GAP &&
+				isPlain(cells, cursorX, x, y, active)) {
+				// Reprinting a few unchanged cells is shorter than moving the cursor over them
+				for (size_t skipped = cursorX; skipped < x; skipped++) {
+					output.append(getCell(cells, skipped, y).glyph, getCell(cells, skipped, y).length);
+				}
+			}
+			else if (static_cast<int>(x) != cursorX || static_cast<int>(y) != cursorY) {
+				output += "\033[" + std::to_string(y + 1) + ";" + std::to_string(x + 1) + "H";
+			}
+			if (cell.style != active) {
+				output += ESCAPE_RESET;
+				output += styles[cell.style];
+				active = cell.style;
+			}
+			output.append(cell.glyph, cell.length);
+			cursorX = static_cast<int>(x) + 1;
+			cursorY = static_cast<int>(y);
+		}
+	}
+	if (!output.empty()) {
+		if (active > 0) {
+			output += ESCAPE_RESET;
+		}
+		// Leave the cursor below the frame, where printing would have left it
+		output += "\033[" + std::to_string(cells.size() + 1) + ";1H";
+	}
+	shown = cells;
+	valid = true;
+	return output;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ScreenCell {
+	// One UTF-8 encoded character
+	char glyph[4] = { ' ' };
+	uint8_t length = 1;
+	uint8_t style = 0;
+	bool operator==(const ScreenCell& other) const;
+	bool operator!=(const ScreenCell& other) const { return !(*this == other); }
+};
+
+// A frame buffer of terminal cells. Each frame is drawn into it from scratch,
+// and rendering compares it with the frame on screen to produce only the
+// escape codes that move the cursor to, and repaint, the cells that changed.
+class Screen {
+private:
+	std::vector<std::vector<ScreenCell>> cells, shown;
+	// Color escape codes in effect for a cell, the first one being none
+	std::vector<std::string> styles = { "" };
+	bool valid = false;
+	uint8_t getStyle(const char* foreground, const char* background);
+	int writeGlyphs(int x, int y, const char* text, size_t length, uint8_t style);
+public:
+	// Starts a new, blank frame
+	void clear();
+	// Makes the next render repaint everything, for when something else drew on the terminal
+	void invalidate() { valid = false; }
+	// Returns the column after the text
+	int write(int x, int y, const char* text, const char* foreground = nullptr, const char* background = nullptr);
+	int write(int x, int y, const std::string& text, const char* foreground = nullptr, const char* background = nullptr);
+	// Text as it would be printed, with line breaks and color escape codes
+	void writeText(int x, int y, const std::string& text);
+	// The output that brings the terminal from the last frame to this one
+	std::string render();
+};
\ No newline at end of file
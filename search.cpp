@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include "search.h"
+#include "ai.h"
+#include "bitbase.h"
+#include "eval.h"
+#include "movegen.h"
+#include "movepick.h"
+#include "profile.h"
+
+static constexpr int ASPIRATION_WINDOW = 50;
+static constexpr int PAWN_SCORE = 100;
+static constexpr int DELTA_MARGIN = 200;
+static constexpr uint64_t NODES_PER_CHECK = 1024;
+
+// Mate scores are stored relative to the position rather than the root, so
+// they stay correct when the entry is found again at a different ply
+int scoreToTable(int score, int ply) {
+	return score >= MATE_BOUND ? score + ply : score <= -MATE_BOUND ? score - ply : score;
+}
+
+int scoreFromTable(int score, int ply) {
+	return score >= MATE_BOUND ? score - ply : score <= -MATE_BOUND ? score + ply : score;
+}
+
+// A quiet move that cuts off becomes a killer for this ply and the counter to
+// the opponent's last move, and gains history at the expense of the quiet
+// moves tried before it
+void Search::updateQuietHistory(Worker& worker, int ply, Move move, Move previous, const MoveList& quietsTried, int depth) {
+	PieceColor us = worker.game.getCurrentTurn();
+	int bonus = depth * depth;
+	worker.history.update(us, move, bonus);
+	for (Move tried : quietsTried) {
+		worker.history.update(us, tried, -bonus);
+	}
+	if (worker.killers[ply][0] != move) {
+		worker.killers[ply][1] = worker.killers[ply][0];
+		worker.killers[ply][0] = move;
+	}
+	if (!previous.isNone()) {
+		worker.counterMoves[previous.getFrom()][previous.getTo()] = move;
+	}
+}
+
+Search::Search(size_t hashMegabytes) : table(hashMegabytes), stopped(false), pondering(false), sharedNodes(0) {}
+
+void Search::checkLimits() {
+	uint64_t nodes = sharedNodes.fetch_add(NODES_PER_CHECK, std::memory_order_relaxed) + NODES_PER_CHECK;
+	PROFILE_COUNT(NODES, NODES_PER_CHECK);
+	PROFILE_REPORT();
+	if (pondering.load(std::memory_order_relaxed)) {
+		return;
+	}
+	if ((limits.nodes > 0 && nodes >= limits.nodes) || timeManager.isPastDeadline()) {
+		stopped = true;
+	}
+}
+
+int Search::search(Worker& worker, int alpha, int beta, int depth, int ply) {
+	Game& game = worker.game;
+	worker.pvLength[ply] = ply;
+	// A side that could do better wouldn't repeat, so one repetition is enough
+	if (ply > 0 && (game.getHalfmoveClock() >= 100 || game.isRepetition(1) || game.isInsufficientMaterial())) {
+		return 0;
+	}
+	// Known endgames are scored exactly, with no subtree to search
+	BitbaseEntry endgame;
+	if (ply > 0 && probeBitbase(game, endgame)) {
+		if (endgame.result == BitbaseResult::DRAW) {
+			return 0;
+		}
+		int distance = ply + endgame.matePlies;
+		int score = distance < MAX_PLY ? MATE_SCORE - distance : MATE_BOUND - 1;
+		return endgame.result == BitbaseResult::WIN ? score : -score;
+	}
+	PieceColor us = game.getCurrentTurn();
+	bool inCheck = game.isInCheck(us);
+	if (inCheck) {
+		depth++;
+	}
+	if (depth <= 0 || ply >= MAX_PLY) {
+		return quiescence(worker, alpha, beta, ply);
+	}
+	if ((++worker.nodes & (NODES_PER_CHECK - 1)) == 0) {
+		checkLimits();
+	}
+	bool pvNode = beta - alpha > 1;
+	// No line from here can beat a mate already found closer to the root
+	alpha = std::max(alpha, -MATE_SCORE + ply);
+	beta = std::min(beta, MATE_SCORE - ply - 1);
+	if (alpha >= beta) {
+		return alpha;
+	}
+	uint64_t key = game.getKey();
+	TableEntry entry;
+	Move hashMove = Move::none();
+	if (table.probe(key, entry)) {
+		hashMove = entry.move;
+		int score = scoreFromTable(entry.score, ply);
+		if (!pvNode && ply > 0 && entry.depth >= depth && (entry.bound == Bound::EXACT ||
+			(entry.bound == Bound::LOWER && score >= beta) || (entry.bound == Bound::UPPER && score <= alpha))) {
+			return score;
+		}
+	}
+	Move previous = ply > 0 ? worker.currentMoves[ply - 1] : Move::none();
+	Move counterMove = previous.isNone() ? Move::none() : worker.counterMoves[previous.getFrom()][previous.getTo()];
+	MovePicker picker(game, hashMove, worker.killers[ply], counterMove, worker.history);
+	MoveList quietsTried;
+	int bestScore = -INFINITE_SCORE, legalMoves = 0;
+	Move bestMove = Move::none();
+	Move move;
+	while (!(move = picker.next()).isNone()) {
+		UndoInfo undo = game.makeMove(move);
+		if (game.isInCheck(us)) {
+			game.unmakeMove(move, undo);
+			continue;
+		}
+		table.prefetch(game.getKey());
+		worker.currentMoves[ply] = move;
+		legalMoves++;
+		int score;
+		if (legalMoves == 1) {
+			score = -search(worker, -beta, -alpha, depth - 1, ply + 1);
+		}
+		else {
+			// Every later move is expected to fail low, a null window proves it
+			// cheaply and only a surprise needs the full window
+			score = -search(worker, -alpha - 1, -alpha, depth - 1, ply + 1);
+			if (score > alpha && score < beta) {
+				score = -search(worker, -beta, -alpha, depth - 1, ply + 1);
+			}
+		}
+		game.unmakeMove(move, undo);
+		if (stopped.load(std::memory_order_relaxed)) {
+			return 0;
+		}
+		bool quiet = !move.isCapture() && !move.isPromotion();
+		if (score > bestScore) {
+			bestScore = score;
+			if (score > alpha) {
+				alpha = score;
+				bestMove = move;
+				worker.pv[ply][ply] = move;
+				std::copy(worker.pv[ply + 1] + ply + 1, worker.pv[ply + 1] + worker.pvLength[ply + 1], worker.pv[ply] + ply + 1);
+				worker.pvLength[ply] = std::max(worker.pvLength[ply + 1], ply + 1);
+				if (alpha >= beta) {
+					worker.cutoffs++;
+					worker.firstMoveCutoffs += legalMoves == 1 ? 1 : 0;
+					if (quiet) {
+						updateQuietHistory(worker, ply, move, previous, quietsTried, depth);
+					}
+					break;
+				}
+			}
+		}
+		if (quiet) {
+			quietsTried.add(move);
+		}
+	}
+	worker.interiorNodes++;
+	worker.movesSearched += legalMoves;
+	if (legalMoves == 0) {
+		return inCheck ? -MATE_SCORE + ply : 0;
+	}
+	Bound bound = bestScore >= beta ? Bound::LOWER : bestMove.isNone() ? Bound::UPPER : Bound::EXACT;
+	table.store(key, bestMove, scoreToTable(bestScore, ply), evaluate(game, *worker.pawns), depth, bound);
+	return bestScore;
+}
+
+// Plays out captures until the position is quiet so the static evaluation is
+// never taken in the middle of an exchange. The side to move can always stand
+// pat on the static evaluation instead of capturing, unless it is in check.
+int Search::quiescence(Worker& worker, int alpha, int beta, int ply) {
+	Game& game = worker.game;
+	worker.pvLength[ply] = ply;
+	if ((++worker.nodes & (NODES_PER_CHECK - 1)) == 0) {
+		checkLimits();
+	}
+	PieceColor us = game.getCurrentTurn();
+	bool inCheck = game.isInCheck(us);
+	if (ply >= MAX_PLY) {
+		return inCheck ? 0 : evaluate(game, *worker.pawns);
+	}
+	bool pvNode = beta - alpha > 1;
+	uint64_t key = game.getKey();
+	TableEntry entry;
+	Move hashMove = Move::none();
+	if (table.probe(key, entry)) {
+		hashMove = entry.move;
+		int score = scoreFromTable(entry.score, ply);
+		if (!pvNode && (entry.bound == Bound::EXACT ||
+			(entry.bound == Bound::LOWER && score >= beta) || (entry.bound == Bound::UPPER && score <= alpha))) {
+			return score;
+		}
+	}
+	int standPat = inCheck ? -INFINITE_SCORE : evaluate(game, *worker.pawns);
+	if (standPat >= beta) {
+		return standPat;
+	}
+	int originalAlpha = alpha;
+	alpha = std::max(alpha, standPat);
+	// In check every evasion has to be tried, not just the captures
+	Move noKillers[2] = { Move::none(), Move::none() };
+	MovePicker picker = inCheck ? MovePicker(game, hashMove, noKillers, Move::none(), worker.history) :
+		MovePicker(game, hashMove, worker.history);
+	int bestScore = standPat, legalMoves = 0;
+	Move bestMove = Move::none();
+	Move move;
+	while (!(move = picker.next()).isNone()) {
+		if (!inCheck) {
+			// Skip captures that couldn't raise alpha even winning the piece
+			// for free, and captures that lose material once recaptured
+			int captured = move.isEnPassant() ? getMaterialValue(PieceType::PAWN) :
+				move.isCapture() ? getMaterialValue(game.getPiece(move.getTo()).getType()) : 0;
+			if (!move.isPromotion() && standPat + captured * PAWN_SCORE + DELTA_MARGIN <= alpha) {
+				continue;
+			}
+			if (getExchangeValue(game, move) < 0) {
+				continue;
+			}
+		}
+		UndoInfo undo = game.makeMove(move);
+		if (game.isInCheck(us)) {
+			game.unmakeMove(move, undo);
+			continue;
+		}
+		legalMoves++;
+		int score = -quiescence(worker, -beta, -alpha, ply + 1);
+		game.unmakeMove(move, undo);
+		if (stopped.load(std::memory_order_relaxed)) {
+			return 0;
+		}
+		if (score > bestScore) {
+			bestScore = score;
+			if (score > alpha) {
+				alpha = score;
+				bestMove = move;
+				if (alpha >= beta) {
+					break;
+				}
+			}
+		}
+	}
+	if (inCheck && legalMoves == 0) {
+		return -MATE_SCORE + ply;
+	}
+	Bound bound = bestScore >= beta ? Bound::LOWER : alpha > originalAlpha ? Bound::EXACT : Bound::UPPER;
+	table.store(key, bestMove, scoreToTable(bestScore, ply), inCheck ? 0 : standPat, 0, bound);
+	return bestScore;
+}
+
+// Searches a narrow window around the previous iteration's score first and
+// widens it whenever the result falls outside
+int Search::searchRoot(Worker& worker, int depth, int previous) {
+	int delta = ASPIRATION_WINDOW;
+	int alpha = -INFINITE_SCORE, beta = INFINITE_SCORE;
+	if (depth >= 4 && previous > -MATE_BOUND && previous < MATE_BOUND) {
+		alpha = std::max(previous - delta, -INFINITE_SCORE);
+		beta = std::min(previous + delta, INFINITE_SCORE);
+	}
+	while (true) {
+		int score = search(worker, alpha, beta, depth, 0);
+		if (stopped.load(std::memory_order_relaxed) || (score > alpha && score < beta)) {
+			return score;
+		}
+		delta *= 2;
+		if (score <= alpha) {
+			alpha = std::max(score - delta, -INFINITE_SCORE);
+		}
+		else {
+			beta = std::min(score + delta, INFINITE_SCORE);
+		}
+	}
+}
+
+void Search::iterate(Worker& worker, int firstDepth, bool main, SearchResult& result) {
+	int maxDepth = limits.depth > 0 ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+	// Every reply to a known endgame is probed exactly, so one iteration settles it
+	BitbaseEntry endgame;
+	bool known = probeBitbase(worker.game, endgame);
+	for (int depth = firstDepth; depth <= maxDepth; depth++) {
+		PROFILE_SCOPE(ITERATION);
+		int score = searchRoot(worker, depth, result.score);
+		// A stopped iteration didn't look at every move, so only a finished one
+		// can be trusted, unless there is nothing better to fall back on
+		if (stopped.load(std::memory_order_relaxed) && !result.bestMove.isNone()) {
+			break;
+		}
+		result.score = score;
+		result.depth = depth;
+		result.pv.assign(worker.pv[0], worker.pv[0] + worker.pvLength[0]);
+		if (!result.pv.empty()) {
+			result.bestMove = result.pv.front();
+		}
+		if (main && iterationCallback) {
+			result.nodes = sharedNodes.load(std::memory_order_relaxed) + worker.nodes % NODES_PER_CHECK;
+			result.seconds = timeManager.getElapsed() / 1000.0;
+			iterationCallback(result);
+		}
+		if (stopped.load(std::memory_order_relaxed) || (main && !pondering.load(std::memory_order_relaxed) && !timeManager.shouldStartIteration())) {
+			break;
+		}
+		// Nor can searching deeper find a mate shorter than one already within reach
+		if (known || (result.isMate() && MATE_SCORE - std::abs(result.score) <= depth)) {
+			break;
+		}
+	}
+}
+
+void Search::prepare(const SearchLimits& limits) {
+	stopped = false;
+	pondering = limits.ponder;
+	prepared = true;
+}
+
+SearchResult Search::run(Game& game, const SearchLimits& limits) {
+	PROFILE_SCOPE(SEARCH);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	this->limits = limits;
+	timeManager.init(limits, game.getCurrentTurn());
+	sharedNodes = 0;
+	std::vector<std::unique_ptr<Worker>> workers;
+	while (static_cast<int>(pawnTables.size()) < threads) {
+		pawnTables.emplace_back(new PawnTable());
+	}
+	for (int i = 0; i < threads; i++) {
+		workers.emplace_back(new Worker());
+		workers.back()->game = game;
+		workers.back()->pawns = pawnTables[i].get();
+		pawnTables[i]->resetStatistics();
+	}
+	if (!prepared) {
+		prepare(limits);
+	}
+	prepared = false;
+	table.newSearch();
+	std::vector<SearchResult> helperResults(threads);
+	std::vector<std::thread> helpers;
+	for (int i = 1; i < threads; i++) {
+		helpers.emplace_back([this, &workers, &helperResults, i]() {
+			iterate(*workers[i], 1 + i % 2, false, helperResults[i]);
+		});
+	}
+	SearchResult result;
+	iterate(*workers[0], 1, true, result);
+	stopped = true;
+	for (std::thread& helper : helpers) {
+		helper.join();
+	}
+	// Stopped before even the first iteration finished, so borrow a helper's
+	// answer or failing that any legal move. None only when there is no move.
+	for (int i = 1; i < threads && result.bestMove.isNone(); i++) {
+		if (!helperResults[i].bestMove.isNone()) {
+			result.bestMove = helperResults[i].bestMove;
+			result.score = helperResults[i].score;
+			result.depth = helperResults[i].depth;
+			result.pv = helperResults[i].pv;
+		}
+	}
+	if (result.bestMove.isNone()) {
+		MoveList moves;
+		generateLegalMoves(game, game.getCurrentTurn(), moves);
+		if (!moves.empty()) {
+			result.bestMove = moves[0];
+			result.score = 0;
+			result.depth = 0;
+			result.pv.assign(1, moves[0]);
+		}
+	}
+	uint64_t interiorNodes = 0, movesSearched = 0;
+	result.nodes = 0;
+	for (const std::unique_ptr<Worker>& worker : workers) {
+		result.threadNodes.push_back(worker->nodes);
+		result.nodes += worker->nodes;
+		result.cutoffs += worker->cutoffs;
+		result.firstMoveCutoffs += worker->firstMoveCutoffs;
+		interiorNodes += worker->interiorNodes;
+		movesSearched += worker->movesSearched;
+		result.pawnProbes += worker->pawns->getProbes();
+		result.pawnHits += worker->pawns->getHits();
+	}
+	result.branchingFactor = interiorNodes > 0 ? static_cast<double>(movesSearched) / interiorNodes : 0;
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "game.h"
+#include "move.h"
+#include "movepick.h"
+#include "pawns.h"
+#include "timeman.h"
+#include "tt.h"
+
+static constexpr int MAX_PLY = 128;
+static constexpr int INFINITE_SCORE = 32000;
+static constexpr int MATE_SCORE = 31000;
+// Any score beyond this is a forced mate, with the distance folded into it
+static constexpr int MATE_BOUND = MATE_SCORE - MAX_PLY;
+
+struct SearchResult {
+	Move bestMove = Move::none();
+	int score = 0;
+	int depth = 0;
+	uint64_t nodes = 0;
+	double seconds = 0;
+	std::vector<Move> pv;
+	std::vector<uint64_t> threadNodes;
+	uint64_t cutoffs = 0;
+	uint64_t firstMoveCutoffs = 0;
+	uint64_t pawnProbes = 0;
+	uint64_t pawnHits = 0;
+	// Legal moves searched per interior node, better ordering brings it down
+	double branchingFactor = 0;
+	bool isMate() const { return score >= MATE_BOUND || score <= -MATE_BOUND; }
+	// Full moves until mate, negative when the side to move is being mated
+	int getMateDistance() const { return score > 0 ? (MATE_SCORE - score + 1) / 2 : -(MATE_SCORE + score) / 2; }
+	uint64_t getNodesPerSecond() const { return seconds > 0 ? static_cast<uint64_t>(nodes / seconds) : 0; }
+	double getFirstMoveCutoffRate() const { return cutoffs > 0 ? static_cast<double>(firstMoveCutoffs) / cutoffs : 0; }
+	double getPawnHitRate() const { return pawnProbes > 0 ? static_cast<double>(pawnHits) / pawnProbes : 0; }
+};
+
+// Iterative deepening negamax with alpha-beta pruning and principal variation
+// search. The transposition table lives as long as the Search, so it stays
+// warm from one move of a game to the next.
+//
+// The search stops at whichever of the limits it reaches first. The time and
+// node limits are checked every few thousand nodes, and a search cut short
+// returns the result of its last completed iteration.
+//
+// With more than one thread the search is Lazy SMP: helper threads search the
+// same root position, half of them one ply deeper, and only share results
+// through the transposition table. The main thread's result is the answer.
+//
+// A pondering search runs on the position after the reply it expects, while
+// the opponent is still thinking, and only starts watching the clock once
+// that reply turns out to be the one played.
+class Search {
+private:
+	struct Worker {
+		Game game;
+		uint64_t nodes = 0, interiorNodes = 0, movesSearched = 0, cutoffs = 0, firstMoveCutoffs = 0;
+		Move pv[MAX_PLY + 1][MAX_PLY + 1];
+		int pvLength[MAX_PLY + 1];
+		Move currentMoves[MAX_PLY + 1];
+		Move killers[MAX_PLY + 1][2];
+		Move counterMoves[SQUARE_COUNT][SQUARE_COUNT];
+		HistoryTable history;
+		PawnTable* pawns;
+	};
+	TranspositionTable table;
+	// One per thread and kept between searches, since pawn structures carry over
+	std::vector<std::unique_ptr<PawnTable>> pawnTables;
+	TimeManager timeManager;
+	SearchLimits limits;
+	std::atomic<bool> stopped, pondering;
+	bool prepared = false;
+	std::atomic<uint64_t> sharedNodes;
+	int threads = 1;
+	std::function<void(const SearchResult&)> iterationCallback;
+	void checkLimits();
+	int search(Worker& worker, int alpha, int beta, int depth, int ply);
+	int quiescence(Worker& worker, int alpha, int beta, int ply);
+	int searchRoot(Worker& worker, int depth, int previous);
+	void updateQuietHistory(Worker& worker, int ply, Move move, Move previous, const MoveList& quietsTried, int depth);
+	void iterate(Worker& worker, int firstDepth, bool main, SearchResult& result);
+public:
+	explicit Search(size_t hashMegabytes = 16);
+	// Clears the stop flag ahead of a search run on another thread, so a stop
+	// or ponder hit sent right after starting that thread isn't overwritten.
+	// Without it, run does the same when it starts.
+	void prepare(const SearchLimits& limits);
+	SearchResult run(Game& game, const SearchLimits& limits);
+	void stop() { stopped = true; }
+	// The expected move was played, so a pondering search starts keeping to its limits
+	void ponderHit() { pondering = false; }
+	int getThreads() const { return threads; }
+	void setThreads(int count) { threads = std::max(1, count); }
+	// Called on the main search thread with the result of each completed iteration
+	void setIterationCallback(std::function<void(const SearchResult&)> callback) { iterationCallback = callback; }
+	TranspositionTable& getTable() { return table; }
+};
\ No newline at end of file
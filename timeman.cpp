@@ -0,0 +1,40 @@
+#include <algorithm>
+
+#include "timeman.h"
+
+// Time lost between deciding on a move and the move reaching the other side
+static constexpr int64_t MOVE_OVERHEAD = 10;
+static constexpr int DEFAULT_MOVES_TO_GO = 30;
+
+void TimeManager::init(const SearchLimits& limits, PieceColor us) {
+	start = std::chrono::steady_clock::now();
+	optimum = maximum = 0;
+	if (limits.infinite) {
+		return;
+	}
+	if (limits.moveTime > 0) {
+		maximum = std::max<int64_t>(1, limits.moveTime - MOVE_OVERHEAD);
+		return;
+	}
+	int color = static_cast<int>(us);
+	if (limits.time[color] > 0) {
+		int64_t remaining = std::max<int64_t>(1, limits.time[color] - MOVE_OVERHEAD);
+		int movesToGo = limits.movesToGo > 0 ? std::min(limits.movesToGo, DEFAULT_MOVES_TO_GO) : DEFAULT_MOVES_TO_GO;
+		optimum = std::min(remaining, remaining / movesToGo + limits.increment[color] * 3 / 4);
+		// An iteration that runs long may use a few times its share, but never
+		// enough to put the rest of the game in danger
+		maximum = std::min(remaining * 4 / 5, optimum * 4);
+		optimum = std::max<int64_t>(1, std::min(optimum, maximum));
+		maximum = std::max(maximum, optimum);
+	}
+}
+
+int64_t TimeManager::getElapsed() const {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The next iteration usually takes a few times longer than the last one, so
+// there is no point starting it once most of the budget is gone
+bool TimeManager::shouldStartIteration() const {
+	return optimum <= 0 || getElapsed() < optimum * 6 / 10;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "piece.h"
+
+struct SearchLimits {
+	// Zero means no limit for every field
+	int depth = 0;
+	uint64_t nodes = 0;
+	int moveTime = 0;
+	int time[2] = { 0, 0 };
+	int increment[2] = { 0, 0 };
+	int movesToGo = 0;
+	bool infinite = false;
+	// Ignores the limits until Search::ponderHit, which then counts them from
+	// the start of the search so the pondering time isn't lost
+	bool ponder = false;
+};
+
+// Turns the limits of a search into two deadlines. The soft deadline is when
+// the search should stop starting new iterations, the hard deadline is when a
+// running iteration gets abandoned. All times are in milliseconds.
+class TimeManager {
+private:
+	std::chrono::steady_clock::time_point start;
+	int64_t optimum = 0, maximum = 0;
+public:
+	void init(const SearchLimits& limits, PieceColor us);
+	int64_t getElapsed() const;
+	bool hasDeadline() const { return maximum > 0; }
+	bool isPastDeadline() const { return maximum > 0 && getElapsed() >= maximum; }
+	bool shouldStartIteration() const;
+};
\ No newline at end of file
@@ -0,0 +1,554 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "tournament.h"
+#include "bitbase.h"
+#include "book.h"
+#include "game.h"
+#include "movegen.h"
+#include "search.h"
+
+static const std::vector<const char*> DEFAULT_OPENINGS = {
+	"r1bqkbnr/1ppp1ppp/p1n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 0 4",
+	"rnbqkb1r/1p2pppp/p2p1n2/8/3NP3/2N5/PPP2PPP/R1BQKB1R w KQkq - 0 6",
+	"rnbqkb1r/ppp2ppp/4pn2/3p4/3PP3/2N5/PPP2PPP/R1BQKBNR w KQkq - 2 4",
+	"rn1qkbnr/pp2pppp/2p5/3pPb2/3P4/8/PPP2PPP/RNBQKBNR w KQkq - 1 4",
+	"rnbqkb1r/ppp2ppp/4pn2/3p4/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 2 4",
+	"rnbqkb1r/pp2pppp/2p2n2/3p4/2PP4/5N2/PP2PPPP/RNBQKB1R w KQkq - 2 4",
+	"rnbqk2r/pppp1ppp/4pn2/8/1bPP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 2 4",
+	"rnbqk2r/ppp1ppbp/3p1np1/8/2PPP3/2N5/PP3PPP/R1BQKBNR w KQkq - 0 5",
+	"r1bqkb1r/pppp1ppp/2n2n2/4p3/2P5/2N2N2/PP1PPPPP/R1BQKB1R w KQkq - 4 4",
+	"rnbqkb1r/ppp2ppp/4pn2/3p4/8/5NP1/PPPPPPBP/RNBQK2R w KQkq - 0 4",
+	"r1bqk1nr/pppp1ppp/2n5/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+	"rnb1kbnr/ppp1pppp/8/q7/8/2N5/PPPP1PPP/R1BQKBNR w KQkq - 2 4",
+	"rnbqkb1r/p2ppppp/5n2/1ppP4/2P5/8/PP2PPPP/RNBQKBNR w KQkq b6 0 4",
+	"r1bqkbnr/pp1ppp1p/2n3p1/2p5/4P3/2N3P1/PPPP1P1P/R1BQKBNR w KQkq - 0 4",
+	"rnbqkb1r/pppp2pp/4pn2/5p2/3P4/6P1/PPP1PPBP/RNBQK1NR w KQkq - 0 4",
+	"rnbqk1nr/ppp1ppbp/3p2p1/8/3PP3/2N5/PPP2PPP/R1BQKBNR w KQkq - 0 4"
+};
+
+static const char* USAGE =
+"Usage: Project2 tournament [options]\n"
+"  --engine <key=value>...  Settings of the next player, given once for each of the two players\n"
+"  --each <key=value>...    Settings of both players\n"
+"      name=<name>          Name in the results and the PGN\n"
+"      tc=<base>[+<inc>]    Clock in seconds, or tc=inf for none (default: 10+0.1)\n"
+"      st=<seconds>         Fixed time per move, replaces the clock\n"
+"      nodes=<n>            Node limit per move\n"
+"      depth=<n>            Depth limit per move\n"
+"      hash=<mb>            Transposition table size (default: 16)\n"
+"      threads=<n>          Search threads (default: 1)\n"
+"      book=<file>          Polyglot book to play from\n"
+"  --games <n>              Games to play, openings alternate colors in pairs (default: 100)\n"
+"  --concurrency <n>        Games played at once (default: hardware threads)\n"
+"  --openings <file>        FEN or EPD positions, one per line (default: a built-in set)\n"
+"  --pgn <file>             Append every finished game to this file\n"
+"  --sprt <elo0> <elo1> [<alpha> <beta>]\n"
+"                           Stop once the test accepts elo0 or elo1 (default errors: 0.05)\n"
+"  --resign <cp> <moves>    Adjudicate a win both engines agree on (default: 1000 3)\n"
+"  --draw <move> <cp> <moves>\n"
+"                           Adjudicate a draw both engines agree on (default: 40 10 8)\n"
+"  --max-moves <n>          Adjudicate a draw after this many moves (default: 200)\n";
+
+enum class Termination {
+	CHECKMATE, STALEMATE, FIFTY_MOVES, REPETITION, INSUFFICIENT_MATERIAL, MOVE_LIMIT, ADJUDICATION, TIME_FORFEIT, ILLEGAL_MOVE
+};
+
+inline const char* getTerminationName(Termination termination) {
+	static constexpr const char* names[] = { "normal", "normal", "normal", "normal", "normal", "adjudication", "adjudication",
+		"time forfeit", "rules infraction" };
+	return names[static_cast<int>(termination)];
+}
+
+struct GameRecord {
+	std::string opening;
+	int white = 0;
+	// Index of the winning player, or -1 for a draw
+	int winner = -1;
+	Termination termination = Termination::CHECKMATE;
+	std::vector<std::string> moveText;
+	int plies = 0;
+};
+
+// A clean sweep would be infinitely many Elo, so the score is kept just shy
+// of 0 and 1 and the difference tops out around 2400
+double getScoreElo(double score) {
+	score = std::max(1e-6, std::min(score, 1 - 1e-6));
+	return 400 * std::log10(score / (1 - score));
+}
+
+double TournamentScore::getElo() const {
+	return getScoreElo(getScore());
+}
+
+// Variance of a single game's score around the mean
+double getScoreVariance(const TournamentScore& score) {
+	double mean = score.getScore();
+	return (score.wins * (1 - mean) * (1 - mean) + score.losses * mean * mean + score.draws * (0.5 - mean) * (0.5 - mean)) /
+		std::max(1, score.getGames());
+}
+
+double TournamentScore::getEloMargin() const {
+	if (getGames() == 0) {
+		return 0;
+	}
+	double deviation = std::sqrt(getScoreVariance(*this) / getGames());
+	double low = std::max(1e-6, getScore() - 1.96 * deviation), high = std::min(1 - 1e-6, getScore() + 1.96 * deviation);
+	return (getScoreElo(high) - getScoreElo(low)) / 2;
+}
+
+// Generalized SPRT with the trinomial result distribution approximated as
+// normal, which is what most engine testing frameworks use
+double TournamentScore::getLogLikelihoodRatio(double elo0, double elo1) const {
+	double variance = getScoreVariance(*this);
+	if (getGames() == 0 || variance <= 0) {
+		return 0;
+	}
+	double score0 = 1 / (1 + std::pow(10, -elo0 / 400)), score1 = 1 / (1 + std::pow(10, -elo1 / 400));
+	return getGames() * (score1 - score0) * (2 * getScore() - score0 - score1) / (2 * variance);
+}
+
+// Standard algebraic notation, which PGN readers require
+std::string getMoveNotation(Game& game, Move move, const MoveList& legalMoves) {
+	std::string notation;
+	int from = move.getFrom(), to = move.getTo();
+	PieceType type = game.getPiece(from).getType();
+	if (move.isCastle()) {
+		notation = move.getFlags() == Move::KING_CASTLE ? "O-O" : "O-O-O";
+	}
+	else if (type == PieceType::PAWN) {
+		if (move.isCapture()) {
+			notation += static_cast<char>('a' + from % BOARD_WIDTH);
+			notation += 'x';
+		}
+		notation += getSquareName(to);
+		if (move.isPromotion()) {
+			notation += '=';
+			notation += getDisplayCharacter(move.getPromotion());
+		}
+	}
+	else {
+		notation += getDisplayCharacter(type);
+		bool ambiguous = false, sameFile = false, sameRank = false;
+		for (Move other : legalMoves) {
+			if (other.getTo() != to || other.getFrom() == from || game.getPiece(other.getFrom()).getType() != type) {
+				continue;
+			}
+			ambiguous = true;
+			sameFile |= other.getFrom() % BOARD_WIDTH == from % BOARD_WIDTH;
+			sameRank |= other.getFrom() / BOARD_WIDTH == from / BOARD_WIDTH;
+		}
+		if (ambiguous && (!sameFile || sameRank)) {
+			notation += static_cast<char>('a' + from % BOARD_WIDTH);
+		}
+		if (ambiguous && sameFile) {
+			notation += static_cast<char>('0' + BOARD_HEIGHT - from / BOARD_WIDTH);
+		}
+		if (move.isCapture()) {
+			notation += 'x';
+		}
+		notation += getSquareName(to);
+	}
+	UndoInfo undo = game.makeMove(move);
+	if (game.isInCheck(game.getCurrentTurn())) {
+		MoveList replies;
+		generateLegalMoves(game, game.getCurrentTurn(), replies);
+		notation += replies.empty() ? '#' : '+';
+	}
+	game.unmakeMove(move, undo);
+	return notation;
+}
+
+bool parsePlayerSetting(const std::string& setting, TournamentPlayer& player) {
+	size_t split = setting.find('=');
+	if (split == std::string::npos) {
+		return false;
+	}
+	std::string key = setting.substr(0, split), value = setting.substr(split + 1);
+	double number = std::atof(value.c_str());
+	if (key == "name") {
+		player.name = value;
+	}
+	else if (key == "tc") {
+		size_t plus = value.find('+');
+		player.base = value == "inf" ? 0 : static_cast<int>(number * 1000);
+		player.increment = value == "inf" || plus == std::string::npos ? 0 : static_cast<int>(std::atof(value.c_str() + plus + 1) * 1000);
+		player.moveTime = 0;
+	}
+	else if (key == "st") {
+		player.base = player.increment = 0;
+		player.moveTime = static_cast<int>(number * 1000);
+	}
+	else if (key == "nodes") {
+		player.nodes = static_cast<uint64_t>(std::max(0.0, number));
+	}
+	else if (key == "depth") {
+		player.depth = std::max(0, static_cast<int>(number));
+	}
+	else if (key == "hash") {
+		player.hashMegabytes = static_cast<size_t>(std::max(1.0, number));
+	}
+	else if (key == "threads") {
+		player.threads = std::max(1, static_cast<int>(number));
+	}
+	else if (key == "book") {
+		player.bookPath = value;
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+bool parseTournamentOptions(int argc, char** argv, TournamentOptions& options) {
+	options.players[0].name = "A";
+	options.players[1].name = "B";
+	options.concurrency = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	int engines = 0;
+	std::string openingsPath;
+	for (int i = 0; i < argc; i++) {
+		std::string argument = argv[i];
+		// Counts the values up to the next option
+		int values = 0;
+		while (i + values + 1 < argc && std::string(argv[i + values + 1]).compare(0, 2, "--") != 0) {
+			values++;
+		}
+		if (argument == "--engine" || argument == "--each") {
+			if (argument == "--engine" && engines >= 2) {
+				std::cerr << "Only two players can take part" << std::endl;
+				return false;
+			}
+			for (int j = 1; j <= values; j++) {
+				for (int player = 0; player < 2; player++) {
+					bool applies = argument == "--each" || player == engines;
+					if (applies && !parsePlayerSetting(argv[i + j], options.players[player])) {
+						std::cerr << "Unknown player setting: " << argv[i + j] << std::endl << USAGE;
+						return false;
+					}
+				}
+			}
+			engines += argument == "--engine" ? 1 : 0;
+		}
+		else if (argument == "--games" && values == 1) {
+			options.games = std::max(1, std::atoi(argv[i + 1]));
+		}
+		else if (argument == "--concurrency" && values == 1) {
+			options.concurrency = std::max(1, std::atoi(argv[i + 1]));
+		}
+		else if (argument == "--openings" && values == 1) {
+			openingsPath = argv[i + 1];
+		}
+		else if (argument == "--pgn" && values == 1) {
+			options.pgnPath = argv[i + 1];
+		}
+		else if (argument == "--sprt" && (values == 2 || values == 4)) {
+			options.sprt = true;
+			options.elo0 = std::atof(argv[i + 1]);
+			options.elo1 = std::atof(argv[i + 2]);
+			if (values == 4) {
+				options.alpha = std::atof(argv[i + 3]);
+				options.beta = std::atof(argv[i + 4]);
+			}
+		}
+		else if (argument == "--resign" && values == 2) {
+			options.resignScore = std::atoi(argv[i + 1]);
+			options.resignMoves = std::max(1, std::atoi(argv[i + 2]));
+		}
+		else if (argument == "--draw" && values == 3) {
+			options.drawMoveNumber = std::atoi(argv[i + 1]);
+			options.drawScore = std::atoi(argv[i + 2]);
+			options.drawMoves = std::max(1, std::atoi(argv[i + 3]));
+		}
+		else if (argument == "--max-moves" && values == 1) {
+			options.maxMoves = std::max(1, std::atoi(argv[i + 1]));
+		}
+		else {
+			std::cerr << USAGE;
+			return false;
+		}
+		i += values;
+	}
+	for (const TournamentPlayer& player : options.players) {
+		if (player.base <= 0 && player.moveTime <= 0 && player.nodes == 0 && player.depth <= 0) {
+			std::cerr << "Player " << player.name << " has no limit on its searches" << std::endl;
+			return false;
+		}
+	}
+	if (openingsPath.empty()) {
+		options.openings.assign(DEFAULT_OPENINGS.begin(), DEFAULT_OPENINGS.end());
+		return true;
+	}
+	std::ifstream file(openingsPath);
+	if (!file) {
+		std::cerr << "Can't open " << openingsPath << std::endl;
+		return false;
+	}
+	std::string line;
+	Game game;
+	while (std::getline(file, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		if (!game.fromFEN(line)) {
+			std::cerr << "Invalid opening: " << line << std::endl;
+			return false;
+		}
+		// EPD operations aren't needed once the position is known
+		options.openings.push_back(game.toFEN());
+	}
+	if (options.openings.empty()) {
+		std::cerr << "No openings in " << openingsPath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+class Tournament {
+private:
+	const TournamentOptions& options;
+	std::atomic<int> nextGame;
+	std::atomic<bool> finished;
+	// Guards everything below, which only changes once per finished game
+	std::mutex mutex;
+	TournamentScore score;
+	std::ofstream pgn;
+	// Mapped once and shared by every game thread
+	OpeningBook books[2];
+	int completed = 0;
+	void playGames();
+	GameRecord playGame(Search* searches[2], const std::string& opening, int white);
+	void writeGame(int round, const GameRecord& record);
+	void report(const GameRecord& record);
+public:
+	explicit Tournament(const TournamentOptions& options) : options(options), nextGame(0), finished(false) {}
+	int run();
+};
+
+GameRecord Tournament::playGame(Search* searches[2], const std::string& opening, int white) {
+	GameRecord record;
+	record.opening = opening;
+	record.white = white;
+	Game game;
+	game.fromFEN(opening);
+	for (int player = 0; player < 2; player++) {
+		searches[player]->getTable().clear();
+	}
+	int clocks[2] = { options.players[0].base, options.players[1].base };
+	int winningPlies = 0, drawnPlies = 0;
+	while (true) {
+		PieceColor turn = game.getCurrentTurn();
+		int player = turn == PieceColor::WHITE ? white : 1 - white;
+		if (!hasLegalMove(game, turn)) {
+			bool mated = game.isInCheck(turn);
+			record.winner = mated ? 1 - player : -1;
+			record.termination = mated ? Termination::CHECKMATE : Termination::STALEMATE;
+			break;
+		}
+		Termination draw = Termination::CHECKMATE;
+		if (game.getHalfmoveClock() >= 100) {
+			draw = Termination::FIFTY_MOVES;
+		}
+		else if (game.isRepetition(2)) {
+			draw = Termination::REPETITION;
+		}
+		else if (game.isInsufficientMaterial()) {
+			draw = Termination::INSUFFICIENT_MATERIAL;
+		}
+		else if (record.plies >= 2 * options.maxMoves) {
+			draw = Termination::MOVE_LIMIT;
+		}
+		if (draw != Termination::CHECKMATE) {
+			record.termination = draw;
+			break;
+		}
+		// Endgames the bitbases know are decided without playing them out
+		BitbaseEntry endgame;
+		if (probeBitbase(game, endgame)) {
+			record.winner = endgame.result == BitbaseResult::DRAW ? -1 : endgame.result == BitbaseResult::WIN ? player : 1 - player;
+			record.termination = Termination::ADJUDICATION;
+			break;
+		}
+		const TournamentPlayer& settings = options.players[player];
+		SearchLimits limits;
+		limits.depth = settings.depth;
+		limits.nodes = settings.nodes;
+		limits.moveTime = settings.moveTime;
+		if (settings.base > 0) {
+			int side = static_cast<int>(turn), other = static_cast<int>(getOpposite(turn));
+			limits.time[side] = clocks[player];
+			limits.increment[side] = settings.increment;
+			limits.time[other] = clocks[1 - player];
+			limits.increment[other] = options.players[1 - player].increment;
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		SearchResult result;
+		result.bestMove = books[player].probe(game, BookSelection::WEIGHTED);
+		if (result.bestMove.isNone()) {
+			result = searches[player]->run(game, limits);
+		}
+		int elapsed = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+		if (settings.base > 0) {
+			clocks[player] -= elapsed;
+			if (clocks[player] < 0) {
+				record.winner = 1 - player;
+				record.termination = Termination::TIME_FORFEIT;
+				break;
+			}
+			clocks[player] += settings.increment;
+		}
+		MoveList moves;
+		generateLegalMoves(game, turn, moves);
+		if (!moves.contains(result.bestMove)) {
+			record.winner = 1 - player;
+			record.termination = Termination::ILLEGAL_MOVE;
+			break;
+		}
+		if (turn == PieceColor::WHITE || record.plies == 0) {
+			record.moveText.push_back(std::to_string(game.getFullmoveNumber()) + (turn == PieceColor::WHITE ? "." : "..."));
+		}
+		record.moveText.push_back(getMoveNotation(game, result.bestMove, moves));
+		record.plies++;
+		int whiteScore = turn == PieceColor::WHITE ? result.score : -result.score;
+		if (whiteScore >= options.resignScore) {
+			winningPlies = std::max(winningPlies, 0) + 1;
+		}
+		else if (whiteScore <= -options.resignScore) {
+			winningPlies = std::min(winningPlies, 0) - 1;
+		}
+		else {
+			winningPlies = 0;
+		}
+		bool quiet = game.getFullmoveNumber() >= options.drawMoveNumber && std::abs(result.score) <= options.drawScore;
+		drawnPlies = quiet ? drawnPlies + 1 : 0;
+		game.makeMove(result.bestMove);
+		if (std::abs(winningPlies) >= 2 * options.resignMoves) {
+			record.winner = winningPlies > 0 ? white : 1 - white;
+			record.termination = Termination::ADJUDICATION;
+			break;
+		}
+		if (drawnPlies >= 2 * options.drawMoves) {
+			record.termination = Termination::ADJUDICATION;
+			break;
+		}
+	}
+	return record;
+}
+
+void Tournament::writeGame(int round, const GameRecord& record) {
+	const char* result = record.winner < 0 ? "1/2-1/2" : record.winner == record.white ? "1-0" : "0-1";
+	std::time_t now = std::time(nullptr);
+	char date[16];
+	std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+	pgn << "[Event \"Self-play tournament\"]\n[Site \"?\"]\n[Date \"" << date << "\"]\n[Round \"" << round << "\"]\n"
+		<< "[White \"" << options.players[record.white].name << "\"]\n[Black \"" << options.players[1 - record.white].name << "\"]\n"
+		<< "[Result \"" << result << "\"]\n[FEN \"" << record.opening << "\"]\n[SetUp \"1\"]\n"
+		<< "[PlyCount \"" << record.plies << "\"]\n[Termination \"" << getTerminationName(record.termination) << "\"]\n\n";
+	size_t width = 0;
+	for (const std::string& token : record.moveText) {
+		if (width > 0 && width + token.size() + 1 > 80) {
+			pgn << '\n';
+			width = 0;
+		}
+		pgn << (width > 0 ? " " : "") << token;
+		width += token.size() + (width > 0 ? 1 : 0);
+	}
+	pgn << (width > 0 ? " " : "") << result << "\n\n";
+	pgn.flush();
+}
+
+void Tournament::report(const GameRecord& record) {
+	static constexpr const char* reasons[] = { "checkmate", "stalemate", "fifty-move rule", "threefold repetition",
+		"insufficient material", "move limit", "adjudication", "time forfeit", "illegal move" };
+	std::lock_guard<std::mutex> lock(mutex);
+	completed++;
+	if (record.winner < 0) {
+		score.draws++;
+	}
+	else if (record.winner == 0) {
+		score.wins++;
+	}
+	else {
+		score.losses++;
+	}
+	if (pgn.is_open()) {
+		writeGame(completed, record);
+	}
+	const char* result = record.winner < 0 ? "1/2-1/2" : record.winner == record.white ? "1-0" : "0-1";
+	std::cout << "Finished game " << completed << " (" << options.players[record.white].name << " vs "
+		<< options.players[1 - record.white].name << "): " << result << " {" << reasons[static_cast<int>(record.termination)] << "}" << std::endl;
+	std::cout << "Score of " << options.players[0].name << " vs " << options.players[1].name << ": " << score.wins << " - "
+		<< score.losses << " - " << score.draws << " [" << std::fixed << std::setprecision(3) << score.getScore() << "] "
+		<< score.getGames() << std::endl;
+	std::cout << "Elo difference: " << std::setprecision(1) << score.getElo() << " +/- " << score.getEloMargin() << std::endl;
+	if (options.sprt) {
+		double ratio = score.getLogLikelihoodRatio(options.elo0, options.elo1);
+		double lower = std::log(options.beta / (1 - options.alpha)), upper = std::log((1 - options.beta) / options.alpha);
+		std::cout << "SPRT: llr " << std::setprecision(2) << ratio << ", lbound " << lower << ", ubound " << upper;
+		if (ratio <= lower || ratio >= upper) {
+			std::cout << " - H" << (ratio >= upper ? 1 : 0) << " was accepted";
+			finished = true;
+		}
+		std::cout << std::endl;
+	}
+}
+
+// Each thread keeps one search per player, so the tables aren't reallocated
+// for every game
+void Tournament::playGames() {
+	std::unique_ptr<Search> players[2];
+	for (int player = 0; player < 2; player++) {
+		players[player].reset(new Search(options.players[player].hashMegabytes));
+		players[player]->setThreads(options.players[player].threads);
+	}
+	Search* searches[2] = { players[0].get(), players[1].get() };
+	while (!finished) {
+		int index = nextGame++;
+		if (index >= options.games) {
+			break;
+		}
+		const std::string& opening = options.openings[(index / 2) % options.openings.size()];
+		report(playGame(searches, opening, index % 2));
+	}
+}
+
+int Tournament::run() {
+	for (int player = 0; player < 2; player++) {
+		const std::string& path = options.players[player].bookPath;
+		if (!path.empty() && !books[player].open(path)) {
+			std::cerr << "Can't open book " << path << std::endl;
+			return 1;
+		}
+	}
+	if (!options.pgnPath.empty()) {
+		pgn.open(options.pgnPath, std::ios::app);
+		if (!pgn) {
+			std::cerr << "Can't write " << options.pgnPath << std::endl;
+			return 1;
+		}
+	}
+	std::cout << "Playing " << options.games << " games of " << options.players[0].name << " vs " << options.players[1].name
+		<< " from " << options.openings.size() << " openings, " << options.concurrency << " at a time" << std::endl;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < std::min(options.concurrency, options.games); i++) {
+		threads.emplace_back([this]() { playGames(); });
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	return 0;
+}
+
+int runTournament(const TournamentOptions& options) {
+	Tournament tournament(options);
+	return tournament.run();
+}
\ No newline at end of file
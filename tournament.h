@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct TournamentPlayer {
+	std::string name;
+	// Clock in milliseconds, or fixed per-move limits when the base is zero
+	int base = 10000, increment = 100;
+	int moveTime = 0, depth = 0;
+	uint64_t nodes = 0;
+	size_t hashMegabytes = 16;
+	int threads = 1;
+	// Polyglot book played from until the position leaves it
+	std::string bookPath;
+};
+
+struct TournamentOptions {
+	TournamentPlayer players[2];
+	int games = 100;
+	int concurrency = 1;
+	std::vector<std::string> openings;
+	std::string pgnPath;
+	// Stop as soon as the test accepts one of the two hypotheses
+	bool sprt = false;
+	double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+	// Adjudicate when both engines agree on a score for this many moves each
+	int resignScore = 1000, resignMoves = 3;
+	int drawScore = 10, drawMoves = 8, drawMoveNumber = 40;
+	int maxMoves = 200;
+};
+
+// Games from the first player's point of view
+struct TournamentScore {
+	int wins = 0, losses = 0, draws = 0;
+	int getGames() const { return wins + losses + draws; }
+	double getScore() const { return getGames() > 0 ? (wins + draws / 2.0) / getGames() : 0.5; }
+	double getElo() const;
+	// Half the width of the 95% confidence interval
+	double getEloMargin() const;
+	double getLogLikelihoodRatio(double elo0, double elo1) const;
+};
+
+bool parseTournamentOptions(int argc, char** argv, TournamentOptions& options);
+int runTournament(const TournamentOptions& options);
\ No newline at end of file
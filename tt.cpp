@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <new>
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+#include "tt.h"
+#include "profile.h"
+
+// Slot data layout: move (16 bits), score (16), eval (16), depth (8),
+// bound (2) and the generation of the search that wrote it (6)
+inline uint64_t packEntry(Move move, int score, int eval, int depth, Bound bound, uint8_t generation) {
+	return static_cast<uint64_t>(move.getData()) | static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16 |
+		static_cast<uint64_t>(static_cast<uint16_t>(eval)) << 32 | static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 48 |
+		static_cast<uint64_t>(bound) << 56 | static_cast<uint64_t>(generation) << 58;
+}
+
+inline Move getEntryMove(uint64_t data) { return Move::fromData(static_cast<uint16_t>(data)); }
+
+inline int getEntryDepth(uint64_t data) { return static_cast<int8_t>(data >> 48); }
+inline uint8_t getEntryGeneration(uint64_t data) { return static_cast<uint8_t>(data >> 58); }
+
+TranspositionTable::TranspositionTable(size_t megabytes) : counters(new Counters[COUNTER_STRIPES]) {
+	resize(megabytes);
+	resetStatistics();
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+	size_t count = 1;
+	while (count * 2 * sizeof(Bucket) <= std::max<size_t>(megabytes, 1) * 1024 * 1024) {
+		count *= 2;
+	}
+	memory.reset();
+	memory.reset(new char[count * sizeof(Bucket) + CACHE_LINE]);
+	uintptr_t address = reinterpret_cast<uintptr_t>(memory.get());
+	buckets = reinterpret_cast<Bucket*>((address + CACHE_LINE - 1) & ~static_cast<uintptr_t>(CACHE_LINE - 1));
+	for (size_t i = 0; i < count; i++) {
+		new (&buckets[i]) Bucket();
+	}
+	mask = count - 1;
+	clear();
+}
+
+void TranspositionTable::clear() {
+	for (size_t i = 0; i <= mask; i++) {
+		for (Slot& slot : buckets[i].slots) {
+			slot.check.store(0, std::memory_order_relaxed);
+			slot.data.store(0, std::memory_order_relaxed);
+		}
+	}
+	generation = 0;
+}
+
+void TranspositionTable::newSearch() {
+	generation = (generation + 1) & 63;
+}
+
+TranspositionTable::Counters& TranspositionTable::getCounters() {
+	static std::atomic<int> nextStripe(0);
+	static thread_local int stripe = nextStripe++ % COUNTER_STRIPES;
+	return counters[stripe];
+}
+
+bool TranspositionTable::probe(uint64_t key, TableEntry& entry) {
+	PROFILE_SCOPE(TABLE_PROBE);
+	Counters& local = getCounters();
+	local.probes.fetch_add(1, std::memory_order_relaxed);
+	Bucket& bucket = buckets[key & mask];
+	for (Slot& slot : bucket.slots) {
+		uint64_t data = slot.data.load(std::memory_order_relaxed);
+		if ((slot.check.load(std::memory_order_relaxed) ^ data) != key || data == 0) {
+			continue;
+		}
+		entry.move = getEntryMove(data);
+		entry.score = static_cast<int16_t>(data >> 16);
+		entry.eval = static_cast<int16_t>(data >> 32);
+		entry.depth = getEntryDepth(data);
+		entry.bound = static_cast<Bound>((data >> 56) & 3);
+		local.hits.fetch_add(1, std::memory_order_relaxed);
+		PROFILE_COUNT(TABLE_HITS, 1);
+		return true;
+	}
+	return false;
+}
+
+// Replaces the slot already holding this position if there is one, otherwise
+// the shallowest slot, counting entries from older searches as shallower
+void TranspositionTable::store(uint64_t key, Move move, int score, int eval, int depth, Bound bound) {
+	getCounters().stores.fetch_add(1, std::memory_order_relaxed);
+	Bucket& bucket = buckets[key & mask];
+	Slot* replace = &bucket.slots[0];
+	int worst = 1 << 30;
+	for (Slot& slot : bucket.slots) {
+		uint64_t data = slot.data.load(std::memory_order_relaxed);
+		if ((slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+			// Keep the move we already know about rather than forgetting it
+			if (move.isNone()) {
+				move = getEntryMove(data);
+			}
+			replace = &slot;
+			break;
+		}
+		int age = (generation - getEntryGeneration(data)) & 63;
+		int value = data == 0 ? -(1 << 30) : getEntryDepth(data) - 8 * age;
+		if (value < worst) {
+			worst = value;
+			replace = &slot;
+		}
+	}
+	uint64_t data = packEntry(move, score, eval, depth, bound, generation);
+	replace->check.store(key ^ data, std::memory_order_relaxed);
+	replace->data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::prefetch(uint64_t key) const {
+#if defined(_MSC_VER)
+	_mm_prefetch(reinterpret_cast<const char*>(&buckets[key & mask]), _MM_HINT_T0);
+#elif defined(__GNUC__)
+	__builtin_prefetch(&buckets[key & mask]);
+#endif
+}
+
+// Samples the first thousand buckets for slots written by the current search
+int TranspositionTable::getUsagePermille() const {
+	size_t sample = std::min<size_t>(1000 / BUCKET_SIZE, mask + 1);
+	int used = 0;
+	for (size_t i = 0; i < sample; i++) {
+		for (const Slot& slot : buckets[i].slots) {
+			uint64_t data = slot.data.load(std::memory_order_relaxed);
+			used += data != 0 && getEntryGeneration(data) == generation ? 1 : 0;
+		}
+	}
+	return static_cast<int>(used * 1000 / (sample * BUCKET_SIZE));
+}
+
+TableStatistics TranspositionTable::getStatistics() const {
+	TableStatistics statistics;
+	for (int i = 0; i < COUNTER_STRIPES; i++) {
+		statistics.probes += counters[i].probes.load(std::memory_order_relaxed);
+		statistics.hits += counters[i].hits.load(std::memory_order_relaxed);
+		statistics.stores += counters[i].stores.load(std::memory_order_relaxed);
+	}
+	return statistics;
+}
+
+void TranspositionTable::resetStatistics() {
+	for (int i = 0; i < COUNTER_STRIPES; i++) {
+		counters[i].probes.store(0, std::memory_order_relaxed);
+		counters[i].hits.store(0, std::memory_order_relaxed);
+		counters[i].stores.store(0, std::memory_order_relaxed);
+	}
+}
\ No newline at end of file
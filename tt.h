@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "move.h"
+
+enum class Bound : uint8_t {
+	NONE, UPPER, LOWER, EXACT
+};
+
+struct TableEntry {
+	Move move;
+	int score;
+	int eval;
+	int depth;
+	Bound bound;
+};
+
+struct TableStatistics {
+	uint64_t probes = 0;
+	uint64_t hits = 0;
+	uint64_t stores = 0;
+	double getHitRate() const { return probes > 0 ? static_cast<double>(hits) / probes : 0; }
+};
+
+// A fixed-size hash table of search results shared by every search thread.
+// Each slot is two words with the key XORed into the first, so a slot torn by
+// two concurrent writers fails verification and reads as a miss, no locks
+// needed. Slots are grouped in buckets that each fill exactly one cache line.
+class TranspositionTable {
+private:
+	static constexpr int BUCKET_SIZE = 4, COUNTER_STRIPES = 64, CACHE_LINE = 64;
+	struct Slot {
+		std::atomic<uint64_t> check, data;
+	};
+	struct Bucket {
+		Slot slots[BUCKET_SIZE];
+	};
+	// Counters are spread over padded stripes so threads don't fight over one
+	// cache line on every probe
+	struct Counters {
+		std::atomic<uint64_t> probes, hits, stores;
+		char padding[CACHE_LINE - 3 * sizeof(std::atomic<uint64_t>)];
+	};
+	std::unique_ptr<char[]> memory;
+	Bucket* buckets = nullptr;
+	size_t mask = 0;
+	uint8_t generation = 0;
+	std::unique_ptr<Counters[]> counters;
+	Counters& getCounters();
+public:
+	explicit TranspositionTable(size_t megabytes);
+	void resize(size_t megabytes);
+	void clear();
+	void newSearch();
+	bool probe(uint64_t key, TableEntry& entry);
+	void store(uint64_t key, Move move, int score, int eval, int depth, Bound bound);
+	void prefetch(uint64_t key) const;
+	size_t getSizeMegabytes() const { return (mask + 1) * sizeof(Bucket) / (1024 * 1024); }
+	int getUsagePermille() const;
+	TableStatistics getStatistics() const;
+	void resetStatistics();
+};
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "uci.h"
+#include "book.h"
+#include "game.h"
+#include "movegen.h"
+#include "search.h"
+
+static constexpr const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+static constexpr int DEFAULT_HASH = 16, MAX_HASH = 65536, MAX_THREADS = 512;
+
+class Uci {
+private:
+	Game game;
+	Search search;
+	OpeningBook book;
+	bool ownBook = false, bestBookMove = false;
+	std::thread searchThread;
+	std::mutex outputMutex, stopMutex;
+	std::condition_variable stopCondition;
+	bool stopRequested = false, pondering = false;
+	void send(const std::string& line);
+	void position(std::istringstream& input);
+	void go(std::istringstream& input);
+	void setOption(std::istringstream& input);
+	void stop();
+	void ponderHit();
+	void sendInfo(const SearchResult& result);
+public:
+	Uci();
+	int run();
+};
+
+Move parseMove(Game& game, const std::string& text) {
+	MoveList moves;
+	generateLegalMoves(game, game.getCurrentTurn(), moves);
+	for (Move move : moves) {
+		if (move.toString() == text) {
+			return move;
+		}
+	}
+	return Move::none();
+}
+
+std::string formatScore(const SearchResult& result) {
+	if (result.isMate()) {
+		return "mate " + std::to_string(result.getMateDistance());
+	}
+	return "cp " + std::to_string(result.score);
+}
+
+Uci::Uci() : search(DEFAULT_HASH) {
+	game.fromFEN(START_FEN);
+	search.setIterationCallback([this](const SearchResult& result) { sendInfo(result); });
+}
+
+// Info lines come from the search thread while the main thread may be
+// answering commands, so every line is written whole under a lock
+void Uci::send(const std::string& line) {
+	std::lock_guard<std::mutex> lock(outputMutex);
+	std::cout << line << std::endl;
+}
+
+void Uci::sendInfo(const SearchResult& result) {
+	uint64_t milliseconds = static_cast<uint64_t>(result.seconds * 1000);
+	std::string line = "info depth " + std::to_string(result.depth) + " score " + formatScore(result) +
+		" nodes " + std::to_string(result.nodes) + " nps " + std::to_string(result.nodes * 1000 / std::max<uint64_t>(1, milliseconds)) +
+		" time " + std::to_string(milliseconds) + " hashfull " + std::to_string(search.getTable().getUsagePermille()) + " pv";
+	for (Move move : result.pv) {
+		line += " " + move.toString();
+	}
+	send(line);
+}
+
+void Uci::position(std::istringstream& input) {
+	std::string token, fen;
+	input >> token;
+	if (token == "startpos") {
+		fen = START_FEN;
+		input >> token;
+	}
+	else if (token == "fen") {
+		while (input >> token && token != "moves") {
+			fen += fen.empty() ? token : " " + token;
+		}
+	}
+	else {
+		return;
+	}
+	Game position;
+	if (!position.fromFEN(fen)) {
+		send("info string invalid fen " + fen);
+		return;
+	}
+	while (input >> token) {
+		Move move = parseMove(position, token);
+		if (move.isNone()) {
+			send("info string illegal move " + token);
+			break;
+		}
+		position.makeMove(move);
+	}
+	game = position;
+}
+
+void Uci::go(std::istringstream& input) {
+	stop();
+	SearchLimits limits;
+	std::string token;
+	while (input >> token) {
+		if (token == "infinite") {
+			limits.infinite = true;
+			continue;
+		}
+		if (token == "ponder") {
+			limits.ponder = true;
+			continue;
+		}
+		long long value = 0;
+		if (!(input >> value)) {
+			break;
+		}
+		int clamped = static_cast<int>(std::max(0LL, std::min(value, 1LL << 30)));
+		if (token == "depth") {
+			limits.depth = clamped;
+		}
+		else if (token == "nodes") {
+			limits.nodes = static_cast<uint64_t>(std::max(0LL, value));
+		}
+		else if (token == "movetime") {
+			limits.moveTime = clamped;
+		}
+		else if (token == "wtime") {
+			limits.time[static_cast<int>(PieceColor::WHITE)] = clamped;
+		}
+		else if (token == "btime") {
+			limits.time[static_cast<int>(PieceColor::BLACK)] = clamped;
+		}
+		else if (token == "winc") {
+			limits.increment[static_cast<int>(PieceColor::WHITE)] = clamped;
+		}
+		else if (token == "binc") {
+			limits.increment[static_cast<int>(PieceColor::BLACK)] = clamped;
+		}
+		else if (token == "movestogo") {
+			limits.movesToGo = clamped;
+		}
+	}
+	// Book moves need no search, so they are answered straight away
+	Move bookMove = ownBook && !limits.infinite && !limits.ponder ? book.probe(game, bestBookMove ? BookSelection::BEST : BookSelection::WEIGHTED) : Move::none();
+	if (!bookMove.isNone()) {
+		send("bestmove " + bookMove.toString());
+		return;
+	}
+	stopRequested = false;
+	pondering = limits.ponder;
+	search.prepare(limits);
+	searchThread = std::thread([this, limits]() {
+		Game position = game;
+		SearchResult result = search.run(position, limits);
+		// An infinite search may only report its move once it has been told to
+		// stop, and a pondering one not before the expected move was played
+		if (limits.infinite || limits.ponder) {
+			std::unique_lock<std::mutex> lock(stopMutex);
+			stopCondition.wait(lock, [this, limits]() { return stopRequested || (!limits.infinite && !pondering); });
+		}
+		std::string line = "bestmove " + result.bestMove.toString();
+		if (result.pv.size() > 1) {
+			line += " ponder " + result.pv[1].toString();
+		}
+		send(line);
+	});
+}
+
+void Uci::setOption(std::istringstream& input) {
+	std::string token, name, value;
+	input >> token;
+	while (input >> token && token != "value") {
+		name += name.empty() ? token : " " + token;
+	}
+	std::getline(input >> std::ws, value);
+	stop();
+	if (name == "Hash") {
+		search.getTable().resize(static_cast<size_t>(std::max(1, std::min(std::atoi(value.c_str()), MAX_HASH))));
+	}
+	else if (name == "Threads") {
+		search.setThreads(std::max(1, std::min(std::atoi(value.c_str()), MAX_THREADS)));
+	}
+	else if (name == "Clear Hash") {
+		search.getTable().clear();
+	}
+	else if (name == "Ponder") {
+		// The GUI decides when to ponder, there is nothing to set up for it
+	}
+	else if (name == "OwnBook") {
+		ownBook = value == "true";
+	}
+	else if (name == "Best Book Move") {
+		bestBookMove = value == "true";
+	}
+	else if (name == "Book File") {
+		if (!book.open(value)) {
+			send("info string can't open book " + value);
+		}
+	}
+	else {
+		send("info string unknown option " + name);
+	}
+}
+
+void Uci::ponderHit() {
+	search.ponderHit();
+	{
+		std::lock_guard<std::mutex> lock(stopMutex);
+		pondering = false;
+	}
+	stopCondition.notify_all();
+}
+
+void Uci::stop() {
+	if (!searchThread.joinable()) {
+		return;
+	}
+	search.stop();
+	{
+		std::lock_guard<std::mutex> lock(stopMutex);
+		stopRequested = true;
+	}
+	stopCondition.notify_all();
+	searchThread.join();
+}
+
+int Uci::run() {
+	std::string line;
+	while (std::getline(std::cin, line)) {
+		std::istringstream input(line);
+		std::string command;
+		input >> command;
+		if (command == "uci") {
+			send("id name Chess");
+			send("id author Quantum64");
+			send("option name Hash type spin default " + std::to_string(DEFAULT_HASH) + " min 1 max " + std::to_string(MAX_HASH));
+			send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+			send("option name Clear Hash type button");
+			send("option name Ponder type check default false");
+			send("option name OwnBook type check default false");
+			send("option name Best Book Move type check default false");
+			send("option name Book File type string default <empty>");
+			send("uciok");
+		}
+		else if (command == "isready") {
+			send("readyok");
+		}
+		else if (command == "setoption") {
+			setOption(input);
+		}
+		else if (command == "ucinewgame") {
+			stop();
+			search.getTable().clear();
+		}
+		else if (command == "position") {
+			stop();
+			position(input);
+		}
+		else if (command == "go") {
+			go(input);
+		}
+		else if (command == "stop") {
+			stop();
+		}
+		else if (command == "ponderhit") {
+			ponderHit();
+		}
+		else if (command == "quit") {
+			break;
+		}
+	}
+	stop();
+	return 0;
+}
+
+int runUci() {
+	std::ios::sync_with_stdio(false);
+	Uci uci;
+	return uci.run();
+}
\ No newline at end of file
@@ -0,0 +1,5 @@
+#pragma once
+
+// Speaks the UCI protocol over standard input and output until "quit", so GUIs
+// and tournament managers can drive the engine. Never touches the console.
+int runUci();
\ No newline at end of file
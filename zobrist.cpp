@@ -0,0 +1,31 @@
+#include "zobrist.h"
+
+inline constexpr uint64_t nextKey(uint64_t& state) {
+	uint64_t key = (state += 0x9E3779B97F4A7C15ULL);
+	key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+	return key ^ (key >> 31);
+}
+
+inline constexpr ZobristKeys createZobristKeys() {
+	ZobristKeys keys = {};
+	uint64_t state = 0x2545F4914F6CDD1DULL;
+	for (int color = 0; color < COLOR_COUNT; color++) {
+		for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+			for (int square = 0; square < SQUARE_COUNT; square++) {
+				keys.pieces[color][type][square] = nextKey(state);
+			}
+		}
+	}
+	// No castling rights hash to zero so positions without them only depend on pieces
+	for (int rights = 1; rights < CASTLING_COMBINATIONS; rights++) {
+		keys.castling[rights] = nextKey(state);
+	}
+	for (int x = 0; x < BOARD_WIDTH; x++) {
+		keys.enPassant[x] = nextKey(state);
+	}
+	keys.side = nextKey(state);
+	return keys;
+}
+
+constexpr ZobristKeys ZOBRIST = createZobristKeys();
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#include "bitboard.h"
+#include "piece.h"
+
+static constexpr int CASTLING_COMBINATIONS = 16;
+
+// Random keys that are XORed together to identify a position. Game keeps the
+// running XOR up to date as pieces move, so a position's key costs nothing.
+struct ZobristKeys {
+	uint64_t pieces[COLOR_COUNT][PIECE_TYPE_COUNT][SQUARE_COUNT];
+	uint64_t castling[CASTLING_COMBINATIONS];
+	uint64_t enPassant[BOARD_WIDTH];
+	uint64_t side;
+};
+
+extern const ZobristKeys ZOBRIST;
+
+inline uint64_t getPieceKey(Piece piece, int square) {
+	return ZOBRIST.pieces[static_cast<int>(piece.getColor())][static_cast<int>(piece.getType())][square];
+}
\ No newline at end of file